@@ -0,0 +1,80 @@
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+#include "coll/coll.hpp"
+
+int main() {
+  const int N = 50000000;
+  std::vector<float> floats;
+  coll::range(N)
+    | coll::map(anony_cc(float(rand() % 1000)))
+    | coll::to(floats);
+
+  auto duration = [](auto exec) {
+    auto start = std::chrono::steady_clock::now();
+    exec();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+  };
+
+  // moving sums of 8 elements
+  auto moving_sum = [](auto& w) {
+    float sum = 0;
+    for (size_t i = 0; i < w.size(); i++) {
+      sum += w[i];
+    }
+    return sum;
+  };
+
+  float runtime_sum = 0;
+  auto runtime_time = duration([&]() {
+    runtime_sum = coll::iterate(floats)
+      | coll::window(8, 1)
+      | coll::map(moving_sum)
+      | coll::max()
+      | coll::unwrap();
+  });
+  std::cout << "window(8, 1) duration: " << runtime_time << " ms." << std::endl;
+
+  float fixed_sum = 0;
+  auto fixed_time = duration([&]() {
+    fixed_sum = coll::iterate(floats)
+      | coll::window<8, 1>()
+      | coll::map(moving_sum)
+      | coll::max()
+      | coll::unwrap();
+  });
+  std::cout << "window<8, 1>() duration: " << fixed_time << " ms." << std::endl;
+
+  float fixed_unrolled_sum = 0;
+  auto fixed_unrolled_time = duration([&]() {
+    fixed_unrolled_sum = coll::iterate(floats)
+      | coll::window<8, 1>()
+      | coll::map([](auto& w) {
+          // all the windows have 8 elements as the step is 1
+          float sum = 0;
+          for (size_t i = 0; i < 8; i++) {
+            sum += w[i];
+          }
+          return sum;
+        })
+      | coll::max()
+      | coll::unwrap();
+  });
+  std::cout << "window<8, 1>() with a loop of 8 duration: " << fixed_unrolled_time << " ms." << std::endl;
+
+  float contiguous_sum = 0;
+  auto contiguous_time = duration([&]() {
+    contiguous_sum = coll::iterate(floats)
+      | coll::window(8, 1).as_view()
+      | coll::map(moving_sum)
+      | coll::max()
+      | coll::unwrap();
+  });
+  std::cout << "window(8, 1).as_view() duration: " << contiguous_time << " ms." << std::endl;
+
+  std::cout << "The max moving sums are" <<
+    (runtime_sum == fixed_sum && fixed_sum == fixed_unrolled_sum && fixed_sum == contiguous_sum ? " " : " not ") <<
+    "the same." << std::endl;
+}
@@ -1,11 +1,9 @@
 #include <algorithm>
 #include <chrono>
-#include <queue>
 #include <vector>
 
 #include "coll/coll.hpp"
 #include "coll/parallel_coll.hpp"
-#include "coll/topk.hpp"
 
 int main() {
   const int N = 50000000;
@@ -52,28 +50,15 @@ int main() {
             );
           });
         })
+        .ordered()
       | coll::aggregate([=](auto&&) {
           // Aggregator
           std::vector<int> vec;
           vec.reserve(N);
           return vec;
-        }, [
-          next_pid = 0,
-          buffer = coll::topk<std::pair<int, std::vector<int>>>(P,
-            [](const auto& a, const auto& b) { return b.first < a.first; }
-          )
-        ](auto& vec, auto&& x) mutable {
-          // Aggregation method 
-          if (x.first == next_pid) {
-            vec.insert(vec.end(), x.second.begin(), x.second.end()); 
-            for (++next_pid; !buffer.empty() && buffer.top().first == next_pid; ++next_pid) {
-              auto& t = buffer.top();
-              vec.insert(vec.end(), t.second.begin(), t.second.end()); 
-              buffer.pop();
-            }
-          } else {
-            buffer.push(std::move(x));
-          }
+        }, [](auto& vec, auto&& x) {
+          // Aggregation method, partitions arrive in the order of pid
+          vec.insert(vec.end(), x.second.begin(), x.second.end());
         });
     sorted_ints2.swap(ints2);
   });
@@ -132,4 +117,14 @@ int main() {
   std::cout << "terasort duration: " << terasort_time << " ms." << std::endl;
   std::cout << "ints is" << (ints1 == ints3 ? " " : " not ") << "the same as ints3." << std::endl;
   ints3.clear();
+
+  std::vector<int> ints4;
+  auto sort_parallel_time = duration([&]() {
+    const int T = 4; // number of threads
+    coll::iterate(ints)
+      | coll::sort().parallel(T)
+      | coll::to(ints4);
+  });
+  std::cout << "sort().parallel() duration: " << sort_parallel_time << " ms." << std::endl;
+  std::cout << "ints is" << (ints1 == ints4 ? " " : " not ") << "the same as ints4." << std::endl;
 }
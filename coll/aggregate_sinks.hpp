@@ -1,6 +1,8 @@
 #pragma once
 
 #include "aggregate.hpp"
+#include "hyperloglog.hpp"
+#include "kll_sketch.hpp"
 #include "lambda.hpp"
 #include "reference.hpp"
 #include "utils.hpp"
@@ -11,6 +13,85 @@ inline auto count() {
   return aggregate(size_t(0), [](auto& cnt, auto&&) { ++cnt; });
 }
 
+// approx_count_distinct
+struct ApproxCountDistinctArgsTag {};
+
+template<bool Sketch>
+struct ApproxCountDistinctArgs {
+  using TagType = ApproxCountDistinctArgsTag;
+
+  size_t precision;
+
+  // Output the `HyperLogLog` sketch instead of the estimate, e.g., to merge the sketches of parallel pipelines.
+  inline ApproxCountDistinctArgs<true> sketch() {
+    return {precision};
+  }
+
+  constexpr static bool output_sketch = Sketch;
+};
+
+// Estimate the number of distinct elements by a `HyperLogLog` sketch of 2^precision bytes.
+inline ApproxCountDistinctArgs<false> approx_count_distinct(size_t precision = HyperLogLog::DefaultPrecision) {
+  return {precision};
+}
+
+template<typename Parent, typename Args,
+  typename P = traits::remove_cvr_t<Parent>,
+  typename A = traits::remove_cvr_t<Args>,
+  std::enable_if_t<std::is_same<typename A::TagType, ApproxCountDistinctArgsTag>::value>* = nullptr,
+  std::enable_if_t<traits::is_pipe_operator<P>::value>* = nullptr>
+inline auto operator | (Parent&& parent, Args&& args) {
+  auto sketch = parent | aggregate(HyperLogLog(args.precision), [](auto& hll, auto&& e) {
+    hll.add(e);
+  });
+  if constexpr (A::output_sketch) {
+    return sketch;
+  } else {
+    return sketch.estimate();
+  }
+}
+
+// quantiles
+struct QuantilesArgsTag {};
+
+template<bool Sketch>
+struct QuantilesArgs {
+  using TagType = QuantilesArgsTag;
+
+  std::vector<double> qs;
+  size_t k;
+
+  // Output the `KllSketch` instead of the quantiles, e.g., to merge the sketches of parallel pipelines.
+  inline QuantilesArgs<true> sketch() {
+    return {std::move(qs), k};
+  }
+
+  constexpr static bool output_sketch = Sketch;
+};
+
+// Estimate the `qs` quantiles, e.g., `quantiles({0.5, 0.99})`, by a `KllSketch` of O(k log(n / k)) elements.
+// The output is empty if there are no elements.
+inline QuantilesArgs<false> quantiles(std::vector<double> qs, size_t k = kll_sketch_utils::DefaultK) {
+  return {std::move(qs), k};
+}
+
+template<typename Parent, typename Args,
+  typename P = traits::remove_cvr_t<Parent>,
+  typename A = traits::remove_cvr_t<Args>,
+  std::enable_if_t<std::is_same<typename A::TagType, QuantilesArgsTag>::value>* = nullptr,
+  std::enable_if_t<traits::is_pipe_operator<P>::value>* = nullptr>
+inline auto operator | (Parent&& parent, Args&& args) {
+  using Elem = traits::remove_cvr_t<typename P::OutputType>;
+  auto sketch = parent | aggregate(KllSketch<Elem>(args.k), [](auto& kll, auto&& e) {
+    kll.add(std::forward<decltype(e)>(e));
+  });
+  if constexpr (A::output_sketch) {
+    return sketch;
+  } else {
+    return sketch.quantiles(args.qs);
+  }
+}
+
 // max, min
 struct MinMaxArgsTag {};
 
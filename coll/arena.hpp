@@ -0,0 +1,44 @@
+#pragma once
+
+#include <algorithm>
+#include <memory_resource>
+
+#include "container_utils.hpp"
+
+namespace coll {
+/**
+ * A bump allocator shared by the buffering operators of a pipeline, e.g.,
+ *
+ *   coll::Arena arena(1 << 20);
+ *   coll::iterate(words)
+ *     | coll::distinct(arena.containers<coll::FlatHashSet>())
+ *     | coll::groupby(anony_rc(_.size()))
+ *         .with_map(arena.maps<coll::FlatHashMap>())
+ *         .aggregate(arena.containers<std::pmr::vector>());
+ *
+ * Memory is taken from an initial block of `bytes` and then from growing blocks of `upstream`.
+ * Deallocation is a no-op, and all the memory is released at once by `release()` or when the arena is destroyed,
+ * so the arena must outlive the containers allocated from it, including the copies of `FlatHashMap`,
+ * `FlatHashSet` and `NodeHashMap`. An arena is not thread-safe.
+ *
+ * `containers<C>()` builds `C<T>(resource)`, for the buffers of `sort`, `reverse().with_buffer()` and `split`,
+ * the sets of `distinct` and the groups of `groupby`.
+ * `maps<M>()` builds `M<K, V>(resource)`, for the maps of `groupby` and `partition`.
+ **/
+class Arena : public std::pmr::monotonic_buffer_resource {
+public:
+  explicit Arena(size_t bytes, std::pmr::memory_resource* upstream = std::pmr::get_default_resource()):
+    std::pmr::monotonic_buffer_resource(std::max<size_t>(bytes, 1), upstream) {
+  }
+
+  template<template<typename ...> class ContainerTemplate>
+  inline ResourceContainerBuilder<ContainerTemplate> containers() {
+    return {this};
+  }
+
+  template<template<typename ...> class MapTemplate>
+  inline ResourceMapBuilder<MapTemplate> maps() {
+    return {this};
+  }
+};
+} // namespace coll
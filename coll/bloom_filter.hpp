@@ -0,0 +1,145 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace coll {
+/**
+ * A blocked Bloom filter for approximate membership with a fixed memory footprint.
+ *
+ * Each element is hashed to one 64-byte block, i.e., one cache line, and sets one bit in each of the 8 words
+ * of the block, where the bit is selected by multiplying the hash by a per-word salt.
+ * So an insertion or a lookup touches a single cache line, and the 8 bits are probed at once by AVX2.
+ *
+ * The number of blocks is decided by the expected number of elements and the false positive rate.
+ * The false positive rate grows beyond the given one if more elements are inserted.
+ **/
+class BlockedBloomFilter {
+public:
+  constexpr static size_t BlockBits = 512;
+  constexpr static size_t NumProbes = 8;
+
+  BlockedBloomFilter(size_t expected_num_elems, double fp_rate):
+    blocks(num_blocks_for(expected_num_elems, fp_rate)) {
+  }
+
+  // insert `e`, return false if it may have been inserted before
+  template<typename T>
+  inline bool insert(const T& e) {
+    return insert_hash(std::hash<T>{}(e));
+  }
+
+  template<typename T>
+  inline bool may_contain(const T& e) const {
+    return may_contain_hash(std::hash<T>{}(e));
+  }
+
+  inline bool insert_hash(uint64_t h) {
+    h = mix(h);
+    auto& block = blocks[block_index(h)];
+#if defined(__AVX2__)
+    __m256i lo, hi;
+    masks(uint32_t(h), lo, hi);
+    auto* words = reinterpret_cast<__m256i*>(block.words);
+    auto w0 = _mm256_load_si256(words), w1 = _mm256_load_si256(words + 1);
+    bool contained = _mm256_testc_si256(w0, lo) && _mm256_testc_si256(w1, hi);
+    _mm256_store_si256(words, _mm256_or_si256(w0, lo));
+    _mm256_store_si256(words + 1, _mm256_or_si256(w1, hi));
+    return !contained;
+#else
+    bool contained = true;
+    for (size_t i = 0; i < NumProbes; i++) {
+      auto m = mask(uint32_t(h), i);
+      contained &= (block.words[i] & m) != 0;
+      block.words[i] |= m;
+    }
+    return !contained;
+#endif
+  }
+
+  inline bool may_contain_hash(uint64_t h) const {
+    h = mix(h);
+    auto& block = blocks[block_index(h)];
+#if defined(__AVX2__)
+    __m256i lo, hi;
+    masks(uint32_t(h), lo, hi);
+    auto* words = reinterpret_cast<const __m256i*>(block.words);
+    return _mm256_testc_si256(_mm256_load_si256(words), lo) &&
+      _mm256_testc_si256(_mm256_load_si256(words + 1), hi);
+#else
+    for (size_t i = 0; i < NumProbes; i++) {
+      if ((block.words[i] & mask(uint32_t(h), i)) == 0) {
+        return false;
+      }
+    }
+    return true;
+#endif
+  }
+
+  // the memory footprint in bytes
+  inline size_t size_in_bytes() const {
+    return blocks.size() * sizeof(Block);
+  }
+
+  /**
+   * The number of bits per element for false positive rate p with k probes is -k / ln(1 - p^(1/k)),
+   * which is scaled by 1.15 as the elements are unevenly distributed to the blocks.
+   **/
+  static size_t num_blocks_for(size_t expected_num_elems, double fp_rate) {
+    fp_rate = std::clamp(fp_rate, 1e-9, 0.5);
+    double bits_per_elem = -double(NumProbes) / std::log(1 - std::pow(fp_rate, 1.0 / NumProbes)) * 1.15;
+    auto bits = double(std::max<size_t>(expected_num_elems, 1)) * bits_per_elem;
+    return std::max<size_t>(size_t(std::ceil(bits / BlockBits)), 1);
+  }
+
+private:
+  struct alignas(64) Block {
+    uint64_t words[NumProbes] = {};
+  };
+
+  // the salts of the split block Bloom filter of Apache Parquet
+  constexpr static uint32_t Salts[NumProbes] = {
+    0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+    0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U
+  };
+
+  // the finalizer of MurmurHash3, as `std::hash` of integers is identity
+  static inline uint64_t mix(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+  }
+
+  // the upper 32 bits select the block, and the lower 32 bits select the bits in the block
+  inline size_t block_index(uint64_t h) const {
+    return size_t(((h >> 32) * blocks.size()) >> 32);
+  }
+
+  static inline uint64_t mask(uint32_t key, size_t i) {
+    return uint64_t(1) << ((key * Salts[i]) >> 26);
+  }
+
+#if defined(__AVX2__)
+  // the masks of words 0-3 and 4-7
+  static inline void masks(uint32_t key, __m256i& lo, __m256i& hi) {
+    auto salts = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(Salts));
+    auto shifts = _mm256_srli_epi32(_mm256_mullo_epi32(_mm256_set1_epi32(key), salts), 26);
+    auto ones = _mm256_set1_epi64x(1);
+    lo = _mm256_sllv_epi64(ones, _mm256_cvtepu32_epi64(_mm256_castsi256_si128(shifts)));
+    hi = _mm256_sllv_epi64(ones, _mm256_cvtepu32_epi64(_mm256_extracti128_si256(shifts, 1)));
+  }
+#endif
+
+  std::vector<Block> blocks;
+};
+} // namespace coll
@@ -5,6 +5,7 @@
 #include <array>
 #include <iterator>
 
+#include "arena.hpp"
 #include "base.hpp"
 #include "lambda.hpp"
 #include "traits.hpp"
@@ -31,7 +32,9 @@
 #include "reverse.hpp"
 #include "sort.hpp"
 #include "split.hpp"
+#include "split_text.hpp"
 #include "take_while.hpp"
+#include "time_window.hpp"
 #include "traversal.hpp"
 #include "unique.hpp"
 #include "unwrap.hpp"
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <memory_resource>
+
 #include "traits.hpp"
 #include "utils.hpp"
 
@@ -64,4 +66,27 @@ struct ContainerBuilder {
   template<typename T>
   inline ContainerTemplate<T> operator()(Type<T>) { return {}; };
 };
+
+template<template <typename ...> class MapTemplate>
+struct MapBuilder {
+  template<typename K, typename V>
+  inline MapTemplate<K, V> operator()(Type<K>, Type<V>) { return {}; };
+};
+
+// Builders of the containers that allocate from `resource`, e.g., `std::pmr::vector` and `FlatHashMap`
+template<template<typename ...> class ContainerTemplate>
+struct ResourceContainerBuilder {
+  std::pmr::memory_resource* resource;
+
+  template<typename T>
+  inline ContainerTemplate<T> operator()(Type<T>) { return ContainerTemplate<T>(resource); };
+};
+
+template<template <typename ...> class MapTemplate>
+struct ResourceMapBuilder {
+  std::pmr::memory_resource* resource;
+
+  template<typename K, typename V>
+  inline MapTemplate<K, V> operator()(Type<K>, Type<V>) { return MapTemplate<K, V>(resource); };
+};
 } // namespace coll
@@ -1,8 +1,8 @@
 #pragma once
 
-#include <unordered_set>
-
 #include "base.hpp"
+#include "bloom_filter.hpp"
+#include "flat_hash_map.hpp"
 #include "reference.hpp"
 
 namespace coll {
@@ -25,6 +25,21 @@ struct DistinctArgs {
     };
   }
 
+  /**
+   * Remember the elements by a `BlockedBloomFilter` sized for `expected_num_elems` elements,
+   * instead of keeping all of them in the set. The memory is fixed, but an element is dropped as
+   * a duplicate with probability about `fp_rate` when it is a false positive of the filter.
+   **/
+  inline auto approx(double fp_rate, size_t expected_num_elems) {
+    auto builder = [=](auto) {
+      return BlockedBloomFilter(expected_num_elems, fp_rate);
+    };
+    auto inserter = [](auto& bloom, auto& e) -> bool {
+      return bloom.insert(e);
+    };
+    return DistinctArgs<decltype(builder), decltype(inserter), false>{builder, inserter};
+  }
+
   // used by operator
   template<typename Input>
   using ElemType = std::conditional_t<CacheByRef,
@@ -48,6 +63,14 @@ distinct(SetBuilder&& builder, Inserter&& ins) {
   return {std::forward<SetBuilder>(builder), std::forward<Inserter>(ins)};
 }
 
+// `builder` returns a set that has `insert`, e.g., `distinct(arena.containers<FlatHashSet>())`
+template<typename SetBuilder>
+inline auto distinct(SetBuilder&& builder) {
+  return distinct(std::forward<SetBuilder>(builder), [](auto& set, auto&& e) -> bool {
+    return set.insert(std::forward<decltype(e)>(e)).second;
+  });
+}
+
 template<template <typename ...> class Set, typename Inserter>
 inline auto distinct(Inserter&& ins) {
   return distinct([](auto type) {
@@ -64,8 +87,9 @@ inline auto distinct() {
     });
 }
 
+// Use `distinct<std::unordered_set>()` for the std container
 inline auto distinct() {
-  return distinct<std::unordered_set>();
+  return distinct<FlatHashSet>();
 }
 
 template<typename Parent, typename Args>
@@ -0,0 +1,225 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if ENABLE_PARALLEL
+#include "zaf/zaf.hpp"
+#endif
+
+namespace coll {
+#if ENABLE_PARALLEL
+namespace parallel_utils {
+static zaf::ActorSystem actor_system;
+} // namespace parallel_utils
+#endif
+
+/**
+ * A persistent pool of executors shared by `parallel` operators and by repeated executions of pipelines.
+ *
+ * 1. Workers are warm threads that are leased to `parallel(...).with_channels()`, `groupby(...).parallel(n)`
+ *    and `sort().parallel(n)`. A lease owns its workers exclusively until it is released, so pipelines running
+ *    at the same time never share a worker. If there are not enough idle workers, new workers are created and
+ *    kept in the pool. The workers are available without `ENABLE_PARALLEL`.
+ * 2. The actors of `parallel` without channels are spawned on an `zaf::ActorEngine` owned by the pool,
+ *    such that their threads are not created or destroyed per execution. Requires `ENABLE_PARALLEL`.
+ *
+ * The pool must outlive all the pipelines that execute by it.
+ **/
+class ExecutorPool {
+private:
+  class Worker {
+  public:
+    Worker():
+      thread([this]() { loop(); }) {
+    }
+
+    ~Worker() {
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopped = true;
+      }
+      cv.notify_all();
+      thread.join();
+    }
+
+    void run(std::function<void()> t) {
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        task = std::move(t);
+        busy = true;
+      }
+      cv.notify_all();
+    }
+
+    void wait() {
+      std::unique_lock<std::mutex> lock(mutex);
+      cv.wait(lock, [this]() { return !busy; });
+    }
+
+  private:
+    void loop() {
+      std::unique_lock<std::mutex> lock(mutex);
+      while (true) {
+        cv.wait(lock, [this]() { return busy || stopped; });
+        if (busy) {
+          lock.unlock();
+          task();
+          lock.lock();
+          task = nullptr;
+          busy = false;
+          cv.notify_all();
+        } else {
+          return;
+        }
+      }
+    }
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::function<void()> task;
+    bool busy = false;
+    bool stopped = false;
+    // constructed last because it uses the members above
+    std::thread thread;
+  };
+
+public:
+  class Lease {
+  public:
+    Lease() = default;
+
+    Lease(ExecutorPool* pool, std::vector<Worker*>&& workers):
+      pool(pool),
+      workers(std::move(workers)) {
+    }
+
+    Lease(const Lease&) = delete;
+    Lease& operator=(const Lease&) = delete;
+
+    Lease(Lease&& other):
+      pool(other.pool),
+      workers(std::move(other.workers)) {
+      other.pool = nullptr;
+    }
+
+    Lease& operator=(Lease&& other) {
+      release();
+      pool = other.pool;
+      workers = std::move(other.workers);
+      other.pool = nullptr;
+      return *this;
+    }
+
+    ~Lease() {
+      release();
+    }
+
+    // run the task on the i-th leased worker
+    inline void run(size_t i, std::function<void()> task) {
+      workers[i]->run(std::move(task));
+    }
+
+    // wait for the tasks on all the leased workers to complete
+    void wait() {
+      for (auto w : workers) {
+        w->wait();
+      }
+    }
+
+    // wait for the tasks and return the workers to the pool
+    void release() {
+      if (pool) {
+        wait();
+        pool->give_back(workers);
+        workers.clear();
+        pool = nullptr;
+      }
+    }
+
+    inline size_t size() const { return workers.size(); }
+
+  private:
+    ExecutorPool* pool = nullptr;
+    std::vector<Worker*> workers;
+  };
+
+  // `n` workers are created in advance, and the actor engine uses `n` threads
+  explicit ExecutorPool(size_t n = std::thread::hardware_concurrency()):
+    ExecutorPool(n, n) {
+  }
+
+  ExecutorPool(size_t num_workers, size_t num_actor_threads):
+    num_threads(std::max<size_t>(num_actor_threads, 1)) {
+    for (size_t i = 0; i < num_workers; i++) {
+      workers.emplace_back(new Worker());
+      idle_workers.push_back(workers.back().get());
+    }
+  }
+
+  ExecutorPool(const ExecutorPool&) = delete;
+  ExecutorPool& operator=(const ExecutorPool&) = delete;
+
+  Lease lease(size_t num_workers) {
+    std::vector<Worker*> leased;
+    leased.reserve(num_workers);
+    std::lock_guard<std::mutex> lock(mutex);
+    for (; leased.size() < num_workers && !idle_workers.empty(); idle_workers.pop_back()) {
+      leased.push_back(idle_workers.back());
+    }
+    while (leased.size() < num_workers) {
+      workers.emplace_back(new Worker());
+      leased.push_back(workers.back().get());
+    }
+    return {this, std::move(leased)};
+  }
+
+#if ENABLE_PARALLEL
+  zaf::ActorGroup& actor_group() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!actor_engine) {
+      actor_engine.reset(new zaf::ActorEngine{parallel_utils::actor_system, num_threads});
+    }
+    return *actor_engine;
+  }
+#endif
+
+  inline size_t num_workers() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return workers.size();
+  }
+
+  inline size_t num_idle_workers() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return idle_workers.size();
+  }
+
+private:
+  void give_back(const std::vector<Worker*>& leased) {
+    std::lock_guard<std::mutex> lock(mutex);
+    idle_workers.insert(idle_workers.end(), leased.begin(), leased.end());
+  }
+
+  const size_t num_threads;
+  std::mutex mutex;
+  std::vector<std::unique_ptr<Worker>> workers;
+  std::vector<Worker*> idle_workers;
+#if ENABLE_PARALLEL
+  std::unique_ptr<zaf::ActorEngine> actor_engine;
+#endif
+};
+
+namespace parallel_utils {
+// used by the `parallel` operators that are not given an `ExecutorPool` or an actor group,
+// whose workers are created on demand and whose actor engine uses all the hardware threads
+inline ExecutorPool& default_executor_pool() {
+  static ExecutorPool pool(0, std::thread::hardware_concurrency());
+  return pool;
+}
+} // namespace parallel_utils
+} // namespace coll
@@ -0,0 +1,606 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace coll {
+namespace flat_hash_utils {
+/**
+ * The control byte of a slot.
+ * A full slot stores the lower 7 bits of the hash of its key (H2), while empty and deleted slots are negative.
+ **/
+using CtrlByte = int8_t;
+constexpr CtrlByte Empty = -128;
+constexpr CtrlByte Deleted = -2;
+
+// The slots are probed group by group, and the control bytes of a group are matched all at once
+constexpr size_t GroupSize = 16;
+
+class Group {
+public:
+  explicit Group(const CtrlByte* ctrl):
+#if defined(__SSE2__)
+    ctrl(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl))) {
+#else
+    ctrl(ctrl) {
+#endif
+  }
+
+  // the i-th bit is set if the i-th slot in the group has control byte `h2`
+  inline uint32_t match(CtrlByte h2) const {
+#if defined(__SSE2__)
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), ctrl));
+#else
+    uint32_t bits = 0;
+    for (size_t i = 0; i < GroupSize; i++) {
+      bits |= uint32_t(ctrl[i] == h2) << i;
+    }
+    return bits;
+#endif
+  }
+
+  inline uint32_t match_empty() const {
+    return match(Empty);
+  }
+
+  // empty or deleted
+  inline uint32_t match_free() const {
+#if defined(__SSE2__)
+    return _mm_movemask_epi8(ctrl);
+#else
+    uint32_t bits = 0;
+    for (size_t i = 0; i < GroupSize; i++) {
+      bits |= uint32_t(ctrl[i] < 0) << i;
+    }
+    return bits;
+#endif
+  }
+
+private:
+#if defined(__SSE2__)
+  __m128i ctrl;
+#else
+  const CtrlByte* ctrl;
+#endif
+};
+
+inline size_t lowest_bit(uint32_t bits) {
+  return __builtin_ctz(bits);
+}
+
+// `std::hash` of integers is identity, so the hash is mixed before being split into the group index and H2
+inline uint64_t mix(uint64_t h) {
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  return h;
+}
+
+template<typename Key, typename Value>
+struct TableValue {
+  using type = std::pair<const Key, Value>;
+
+  static inline const Key& key(const type& v) { return v.first; }
+
+  // the key of `v` is moved only if `v` is destroyed right after
+  static inline void transfer(void* to, type& v) {
+    new (to) type(std::move(const_cast<Key&>(v.first)), std::forward<Value>(v.second));
+  }
+};
+
+template<typename Key>
+struct TableValue<Key, void> {
+  using type = Key;
+
+  static inline const Key& key(const type& v) { return v; }
+
+  static inline void transfer(void* to, type& v) {
+    new (to) type(std::move(v));
+  }
+};
+
+/**
+ * An open-addressing hash table in the style of SwissTable.
+ *
+ * 1. A control byte per slot tells whether the slot is empty, deleted or full, and H2 if full.
+ *    A lookup matches H2 against a group of 16 control bytes by SSE2 (or a scalar loop),
+ *    and only compares the keys of the matched slots.
+ * 2. Groups are probed triangularly starting from the group selected by the upper bits of the hash.
+ *    A lookup stops at the first group that has an empty slot.
+ * 3. The table grows by 2x when the full and deleted slots exceed 7/8 of the slots.
+ *
+ * If `IsNode`, the values are allocated separately and the slots store the pointers to them,
+ * such that the addresses of the values are stable across rehashing, like `std::unordered_map`.
+ * Otherwise the values are stored in the slots and moved when rehashing.
+ *
+ * The slots and the values are allocated from a `std::pmr::memory_resource`, which is
+ * `std::pmr::get_default_resource()` unless given, e.g., a `coll::Arena`.
+ * Unlike `std::pmr` containers, a copy allocates from the same resource, as the operators copy
+ * the tables returned by the builders.
+ **/
+template<typename Key, typename Value, typename Hash, typename KeyEqual, bool IsNode>
+class HashTable {
+  using Traits = TableValue<Key, Value>;
+  using Slot = std::conditional_t<IsNode,
+    typename Traits::type*,
+    std::aligned_storage_t<sizeof(typename Traits::type), alignof(typename Traits::type)>
+  >;
+  constexpr static size_t npos = size_t(-1);
+
+public:
+  using key_type = Key;
+  using value_type = typename Traits::type;
+  using size_type = size_t;
+  using hasher = Hash;
+  using key_equal = KeyEqual;
+
+  template<bool IsConst>
+  class Iterator {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = typename Traits::type;
+    using difference_type = std::ptrdiff_t;
+    using reference = std::conditional_t<IsConst, const value_type&, value_type&>;
+    using pointer = std::conditional_t<IsConst, const value_type*, value_type*>;
+    using TablePtr = std::conditional_t<IsConst, const HashTable*, HashTable*>;
+
+    Iterator() = default;
+
+    Iterator(TablePtr table, size_t index):
+      table(table),
+      index(index) {
+    }
+
+    // iterator to const_iterator
+    template<bool C = IsConst, std::enable_if_t<C>* = nullptr>
+    Iterator(const Iterator<false>& other):
+      table(other.table),
+      index(other.index) {
+    }
+
+    inline reference operator*() const { return table->value_at(index); }
+    inline pointer operator->() const { return &table->value_at(index); }
+
+    inline Iterator& operator++() {
+      index = table->next_full(index + 1);
+      return *this;
+    }
+
+    inline Iterator operator++(int) {
+      auto copy = *this;
+      ++*this;
+      return copy;
+    }
+
+    inline bool operator==(const Iterator& other) const { return index == other.index; }
+    inline bool operator!=(const Iterator& other) const { return index != other.index; }
+
+  private:
+    friend class HashTable;
+    template<bool> friend class Iterator;
+
+    TablePtr table = nullptr;
+    size_t index = 0;
+  };
+
+  using iterator = Iterator<false>;
+  using const_iterator = Iterator<true>;
+
+  HashTable() = default;
+
+  explicit HashTable(size_t n, const Hash& hash = Hash(), const KeyEqual& equal = KeyEqual()):
+    hash_fn(hash),
+    equal_fn(equal) {
+    reserve(n);
+  }
+
+  explicit HashTable(std::pmr::memory_resource* resource):
+    resource(resource) {
+  }
+
+  HashTable(const HashTable& other):
+    hash_fn(other.hash_fn),
+    equal_fn(other.equal_fn),
+    resource(other.resource) {
+    reserve(other.size());
+    for (auto& v : other) {
+      insert(v);
+    }
+  }
+
+  HashTable(HashTable&& other) noexcept:
+    hash_fn(std::move(other.hash_fn)),
+    equal_fn(std::move(other.equal_fn)),
+    resource(other.resource),
+    ctrl(other.ctrl),
+    slots(other.slots),
+    capacity(other.capacity),
+    num_elems(other.num_elems),
+    num_deleted(other.num_deleted) {
+    other.ctrl = nullptr;
+    other.slots = nullptr;
+    other.capacity = other.num_elems = other.num_deleted = 0;
+  }
+
+  HashTable& operator=(const HashTable& other) {
+    if (this != &other) {
+      HashTable copy(other);
+      swap(copy);
+    }
+    return *this;
+  }
+
+  HashTable& operator=(HashTable&& other) noexcept {
+    if (this != &other) {
+      HashTable moved(std::move(other));
+      swap(moved);
+    }
+    return *this;
+  }
+
+  ~HashTable() {
+    destroy_all();
+    deallocate(ctrl, capacity);
+  }
+
+  inline iterator begin() { return {this, next_full(0)}; }
+  inline iterator end() { return {this, capacity}; }
+  inline const_iterator begin() const { return {this, next_full(0)}; }
+  inline const_iterator end() const { return {this, capacity}; }
+  inline const_iterator cbegin() const { return begin(); }
+  inline const_iterator cend() const { return end(); }
+
+  inline size_t size() const { return num_elems; }
+  inline bool empty() const { return num_elems == 0; }
+  inline size_t bucket_count() const { return capacity; }
+  inline std::pmr::memory_resource* memory_resource() const { return resource; }
+
+  inline iterator find(const Key& key) {
+    auto i = find_index(key, hash_of(key));
+    return {this, i == npos ? capacity : i};
+  }
+
+  inline const_iterator find(const Key& key) const {
+    auto i = find_index(key, hash_of(key));
+    return {this, i == npos ? capacity : i};
+  }
+
+  inline size_t count(const Key& key) const {
+    return find_index(key, hash_of(key)) != npos;
+  }
+
+  inline bool contains(const Key& key) const {
+    return count(key);
+  }
+
+  // insert the value constructed by `args` if `key` is absent
+  template<typename K, typename ... Args>
+  std::pair<iterator, bool> try_emplace(K&& key, Args&& ... args) {
+    auto h = hash_of(key);
+    auto i = find_index(key, h);
+    if (i != npos) {
+      return {{this, i}, false};
+    }
+    i = prepare_insert(h);
+    if constexpr (std::is_void<Value>::value) {
+      construct(i, std::forward<K>(key));
+    } else {
+      construct(i, std::piecewise_construct,
+        std::forward_as_tuple(std::forward<K>(key)),
+        std::forward_as_tuple(std::forward<Args>(args)...));
+    }
+    commit_insert(i, h);
+    return {{this, i}, true};
+  }
+
+  template<typename ... Args>
+  inline std::pair<iterator, bool> emplace(Args&& ... args) {
+    if constexpr (sizeof...(Args) == 1) {
+      return insert(std::forward<Args>(args)...);
+    } else {
+      return try_emplace(std::forward<Args>(args)...);
+    }
+  }
+
+  inline std::pair<iterator, bool> insert(const value_type& v) {
+    if constexpr (std::is_void<Value>::value) {
+      return try_emplace(v);
+    } else {
+      return try_emplace(v.first, v.second);
+    }
+  }
+
+  inline std::pair<iterator, bool> insert(value_type&& v) {
+    if constexpr (std::is_void<Value>::value) {
+      return try_emplace(std::move(v));
+    } else {
+      return try_emplace(v.first, std::move(v.second));
+    }
+  }
+
+  template<typename P, typename V = Value,
+    std::enable_if_t<!std::is_void<V>::value && !std::is_same<std::decay_t<P>, value_type>::value>* = nullptr>
+  inline std::pair<iterator, bool> insert(P&& p) {
+    return try_emplace(std::forward<P>(p).first, std::forward<P>(p).second);
+  }
+
+  template<typename K, typename V = Value, std::enable_if_t<!std::is_void<V>::value>* = nullptr>
+  inline V& operator[](K&& key) {
+    return try_emplace(std::forward<K>(key)).first->second;
+  }
+
+  template<typename V = Value, std::enable_if_t<!std::is_void<V>::value>* = nullptr>
+  inline V& at(const Key& key) {
+    auto i = find_index(key, hash_of(key));
+    if (i == npos) {
+      throw std::out_of_range("Key not found in hash table.");
+    }
+    return value_at(i).second;
+  }
+
+  template<typename V = Value, std::enable_if_t<!std::is_void<V>::value>* = nullptr>
+  inline const V& at(const Key& key) const {
+    return const_cast<HashTable*>(this)->at(key);
+  }
+
+  // return the iterator to the element after the erased one
+  inline iterator erase(const_iterator pos) {
+    erase_at(pos.index);
+    return {this, next_full(pos.index + 1)};
+  }
+
+  inline iterator erase(iterator pos) {
+    return erase(const_iterator(pos));
+  }
+
+  inline size_t erase(const Key& key) {
+    auto i = find_index(key, hash_of(key));
+    if (i == npos) {
+      return 0;
+    }
+    erase_at(i);
+    return 1;
+  }
+
+  void clear() {
+    destroy_all();
+    if (capacity > 0) {
+      std::memset(ctrl, Empty, capacity);
+    }
+    num_elems = num_deleted = 0;
+  }
+
+  // make room for `n` elements without rehashing
+  void reserve(size_t n) {
+    size_t cap = capacity == 0 ? GroupSize : capacity;
+    while (n > max_load(cap)) {
+      cap *= 2;
+    }
+    if (cap != capacity && n > 0) {
+      resize(cap);
+    }
+  }
+
+  void swap(HashTable& other) noexcept {
+    using std::swap;
+    swap(hash_fn, other.hash_fn);
+    swap(equal_fn, other.equal_fn);
+    swap(resource, other.resource);
+    swap(ctrl, other.ctrl);
+    swap(slots, other.slots);
+    swap(capacity, other.capacity);
+    swap(num_elems, other.num_elems);
+    swap(num_deleted, other.num_deleted);
+  }
+
+  friend bool operator==(const HashTable& a, const HashTable& b) {
+    if (a.size() != b.size()) {
+      return false;
+    }
+    for (auto& v : a) {
+      auto i = b.find(Traits::key(v));
+      if (i == b.end() || !(*i == v)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  friend bool operator!=(const HashTable& a, const HashTable& b) {
+    return !(a == b);
+  }
+
+private:
+  static inline size_t max_load(size_t cap) { return cap - cap / 8; }
+  static inline CtrlByte h2(size_t h) { return CtrlByte(h & 0x7f); }
+
+  inline size_t hash_of(const Key& key) const {
+    return mix(hash_fn(key));
+  }
+
+  inline value_type& value_at(size_t i) {
+    if constexpr (IsNode) {
+      return *slots[i];
+    } else {
+      return *std::launder(reinterpret_cast<value_type*>(&slots[i]));
+    }
+  }
+
+  inline const value_type& value_at(size_t i) const {
+    return const_cast<HashTable*>(this)->value_at(i);
+  }
+
+  inline size_t next_full(size_t i) const {
+    while (i < capacity && ctrl[i] < 0) {
+      ++i;
+    }
+    return i;
+  }
+
+  size_t find_index(const Key& key, size_t h) const {
+    if (capacity == 0) {
+      return npos;
+    }
+    const size_t mask = capacity / GroupSize - 1;
+    size_t g = (h >> 7) & mask;
+    for (size_t step = 1; ; g = (g + step++) & mask) {
+      Group group(&ctrl[g * GroupSize]);
+      for (auto bits = group.match(h2(h)); bits; bits &= bits - 1) {
+        auto i = g * GroupSize + lowest_bit(bits);
+        if (equal_fn(Traits::key(value_at(i)), key)) {
+          return i;
+        }
+      }
+      if (group.match_empty()) {
+        return npos;
+      }
+    }
+  }
+
+  // the first empty or deleted slot to insert an element with hash `h`
+  static size_t find_free(const CtrlByte* ctrl, size_t capacity, size_t h) {
+    const size_t mask = capacity / GroupSize - 1;
+    size_t g = (h >> 7) & mask;
+    for (size_t step = 1; ; g = (g + step++) & mask) {
+      if (auto bits = Group(&ctrl[g * GroupSize]).match_free()) {
+        return g * GroupSize + lowest_bit(bits);
+      }
+    }
+  }
+
+  size_t prepare_insert(size_t h) {
+    if (num_elems + num_deleted + 1 > max_load(capacity)) {
+      // grow if the table is mostly full of elements, otherwise only purge the deleted slots
+      resize(capacity == 0 ? GroupSize
+        : num_elems + 1 > max_load(capacity) / 2 ? capacity * 2
+        : capacity);
+    }
+    return find_free(ctrl, capacity, h);
+  }
+
+  inline void commit_insert(size_t i, size_t h) {
+    num_deleted -= ctrl[i] == Deleted;
+    ctrl[i] = h2(h);
+    ++num_elems;
+  }
+
+  template<typename ... Args>
+  inline void construct(size_t i, Args&& ... args) {
+    if constexpr (IsNode) {
+      auto* node = static_cast<value_type*>(resource->allocate(sizeof(value_type), alignof(value_type)));
+      try {
+        slots[i] = new (node) value_type(std::forward<Args>(args)...);
+      } catch (...) {
+        resource->deallocate(node, sizeof(value_type), alignof(value_type));
+        throw;
+      }
+    } else {
+      new (&slots[i]) value_type(std::forward<Args>(args)...);
+    }
+  }
+
+  inline void destroy(size_t i) {
+    if constexpr (IsNode) {
+      slots[i]->~value_type();
+      resource->deallocate(slots[i], sizeof(value_type), alignof(value_type));
+    } else {
+      value_at(i).~value_type();
+    }
+  }
+
+  void destroy_all() {
+    if (num_elems > 0) {
+      for (size_t i = 0; i < capacity; i++) {
+        if (ctrl[i] >= 0) {
+          destroy(i);
+        }
+      }
+    }
+  }
+
+  void erase_at(size_t i) {
+    destroy(i);
+    --num_elems;
+    // lookups never probe beyond a group with an empty slot, so the slot can be empty again if its group has one
+    if (Group(&ctrl[i / GroupSize * GroupSize]).match_empty()) {
+      ctrl[i] = Empty;
+    } else {
+      ctrl[i] = Deleted;
+      ++num_deleted;
+    }
+  }
+
+  // the control bytes are followed by the slots in one allocation
+  static inline size_t slots_offset(size_t cap) {
+    return (cap + alignof(Slot) - 1) / alignof(Slot) * alignof(Slot);
+  }
+
+  static inline size_t allocation_size(size_t cap) {
+    return slots_offset(cap) + cap * sizeof(Slot);
+  }
+
+  inline void deallocate(CtrlByte* c, size_t cap) {
+    if (cap > 0) {
+      resource->deallocate(c, allocation_size(cap), alignof(Slot));
+    }
+  }
+
+  void resize(size_t new_capacity) {
+    auto* new_ctrl = static_cast<CtrlByte*>(resource->allocate(allocation_size(new_capacity), alignof(Slot)));
+    auto* new_slots = reinterpret_cast<Slot*>(reinterpret_cast<char*>(new_ctrl) + slots_offset(new_capacity));
+    std::memset(new_ctrl, Empty, new_capacity);
+    for (size_t i = 0; i < capacity; i++) {
+      if (ctrl[i] >= 0) {
+        auto h = hash_of(Traits::key(value_at(i)));
+        auto j = find_free(new_ctrl, new_capacity, h);
+        new_ctrl[j] = h2(h);
+        if constexpr (IsNode) {
+          new_slots[j] = slots[i];
+        } else {
+          Traits::transfer(&new_slots[j], value_at(i));
+          value_at(i).~value_type();
+        }
+      }
+    }
+    deallocate(ctrl, capacity);
+    ctrl = new_ctrl;
+    slots = new_slots;
+    capacity = new_capacity;
+    num_deleted = 0;
+  }
+
+  Hash hash_fn{};
+  KeyEqual equal_fn{};
+  std::pmr::memory_resource* resource = std::pmr::get_default_resource();
+  CtrlByte* ctrl = nullptr;
+  Slot* slots = nullptr;
+  // the number of slots, which is 0 or a power of 2 no less than `GroupSize`
+  size_t capacity = 0;
+  size_t num_elems = 0;
+  size_t num_deleted = 0;
+};
+} // namespace flat_hash_utils
+
+// The default table of `groupby` and `distinct`
+template<typename K, typename V, typename Hash = std::hash<K>, typename KeyEqual = std::equal_to<K>>
+using FlatHashMap = flat_hash_utils::HashTable<K, V, Hash, KeyEqual, false>;
+
+template<typename K, typename Hash = std::hash<K>, typename KeyEqual = std::equal_to<K>>
+using FlatHashSet = flat_hash_utils::HashTable<K, void, Hash, KeyEqual, false>;
+
+// The default table of `partition`, whose values must not be moved, e.g., the pipelines of the partitions
+template<typename K, typename V, typename Hash = std::hash<K>, typename KeyEqual = std::equal_to<K>>
+using NodeHashMap = flat_hash_utils::HashTable<K, V, Hash, KeyEqual, true>;
+} // namespace coll
@@ -1,24 +1,45 @@
 #pragma once
 
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
 #include <vector>
 #include <utility>
-#include <unordered_map>
 
 #include "aggregate.hpp"
 #include "base.hpp"
 #include "container_utils.hpp"
+#include "executor_pool.hpp"
+#include "flat_hash_map.hpp"
 #include "groupby_adjacent.hpp"
+#include "hyperloglog.hpp"
+#include "kll_sketch.hpp"
 #include "reference.hpp"
+#include "spill.hpp"
 
 namespace coll {
 struct GroupByArgsTag {};
 
+// The aggregation of `groupby(...).count()`, which lets parallel groupby combine the counts by sum
+struct GroupCounter {
+  template<typename C, typename E>
+  inline void operator()(C& cnt, E&&) const {
+    ++cnt;
+  }
+};
+
+template<typename GroupByArgsType, typename Combiner>
+struct ParallelGroupByArgs;
+
 template<typename KeyBy,
   typename ValueBy = Identity::type,
   typename Aggregator = NullArg,
   typename AggregateTo = NullArg,
   bool CacheByRef = false,
-  bool Adjacenct = false>
+  bool Adjacenct = false,
+  typename MapBuilderType = MapBuilder<FlatHashMap>>
 struct GroupByArgs {
   using TagType = GroupByArgsTag;
   using AggregatorType = Aggregator;
@@ -27,51 +48,97 @@ struct GroupByArgs {
   ValueBy valby = Identity::value;
   Aggregator aggregator{};
   AggregateTo aggregate_to{};
+  MapBuilderType map_builder{};
 
   // used by user
   template<typename AnotherAggregator, typename AnotherAggregateTo>
-  inline GroupByArgs<KeyBy, ValueBy, AnotherAggregator, AnotherAggregateTo, CacheByRef, Adjacenct>
+  inline GroupByArgs<KeyBy, ValueBy, AnotherAggregator, AnotherAggregateTo, CacheByRef, Adjacenct, MapBuilderType>
   aggregate(AnotherAggregator a, AnotherAggregateTo b) {
     return {std::forward<KeyBy>(keyby), std::forward<ValueBy>(valby),
-            std::forward<AnotherAggregator>(a), std::forward<AnotherAggregateTo>(b)};
+            std::forward<AnotherAggregator>(a), std::forward<AnotherAggregateTo>(b),
+            std::forward<MapBuilderType>(map_builder)};
   }
 
   template<typename AnotherAggregator>
-  inline GroupByArgs<KeyBy, ValueBy, AnotherAggregator, DefaultContainerInserter::type, CacheByRef, Adjacenct>
+  inline GroupByArgs<KeyBy, ValueBy, AnotherAggregator, DefaultContainerInserter::type, CacheByRef, Adjacenct, MapBuilderType>
   aggregate(AnotherAggregator a) {
     return {std::forward<KeyBy>(keyby), std::forward<ValueBy>(valby),
-            std::forward<AnotherAggregator>(a), DefaultContainerInserter::value};
+            std::forward<AnotherAggregator>(a), DefaultContainerInserter::value,
+            std::forward<MapBuilderType>(map_builder)};
   }
 
-  inline GroupByArgs<KeyBy, ValueBy, Aggregator, AggregateTo, true, Adjacenct>
+  inline GroupByArgs<KeyBy, ValueBy, Aggregator, AggregateTo, true, Adjacenct, MapBuilderType>
   cache_by_ref() {
     return {std::forward<KeyBy>(keyby), std::forward<ValueBy>(valby),
-            std::forward<Aggregator>(aggregator), std::forward<AggregateTo>(aggregate_to)};
+            std::forward<Aggregator>(aggregator), std::forward<AggregateTo>(aggregate_to),
+            std::forward<MapBuilderType>(map_builder)};
   }
 
-  inline GroupByArgs<KeyBy, ValueBy, Aggregator, AggregateTo, CacheByRef, true>
+  inline GroupByArgs<KeyBy, ValueBy, Aggregator, AggregateTo, CacheByRef, true, MapBuilderType>
   adjacent() {
     return {std::forward<KeyBy>(keyby), std::forward<ValueBy>(valby),
-            std::forward<Aggregator>(aggregator), std::forward<AggregateTo>(aggregate_to)};
+            std::forward<Aggregator>(aggregator), std::forward<AggregateTo>(aggregate_to),
+            std::forward<MapBuilderType>(map_builder)};
   }
 
   template<typename AnotherValueBy>
-  inline GroupByArgs<KeyBy, AnotherValueBy, Aggregator, AggregateTo, CacheByRef, Adjacenct>
+  inline GroupByArgs<KeyBy, AnotherValueBy, Aggregator, AggregateTo, CacheByRef, Adjacenct, MapBuilderType>
   valueby(AnotherValueBy another_valueby) {
     return {std::forward<KeyBy>(keyby), std::forward<AnotherValueBy>(another_valueby),
+            std::forward<Aggregator>(aggregator), std::forward<AggregateTo>(aggregate_to),
+            std::forward<MapBuilderType>(map_builder)};
+  }
+
+  // The map of the groups is `FlatHashMap` by default, e.g., `with_map<std::unordered_map>()` for the std one.
+  template<template<typename ...> class AnotherMap>
+  inline GroupByArgs<KeyBy, ValueBy, Aggregator, AggregateTo, CacheByRef, Adjacenct, MapBuilder<AnotherMap>>
+  with_map() {
+    return {std::forward<KeyBy>(keyby), std::forward<ValueBy>(valby),
             std::forward<Aggregator>(aggregator), std::forward<AggregateTo>(aggregate_to)};
   }
 
+  // `another_map_builder(Type<K>{}, Type<V>{})` returns the map, e.g., `with_map(arena.maps<FlatHashMap>())`.
+  template<typename AnotherMapBuilder>
+  inline GroupByArgs<KeyBy, ValueBy, Aggregator, AggregateTo, CacheByRef, Adjacenct, AnotherMapBuilder>
+  with_map(AnotherMapBuilder another_map_builder) {
+    return {std::forward<KeyBy>(keyby), std::forward<ValueBy>(valby),
+            std::forward<Aggregator>(aggregator), std::forward<AggregateTo>(aggregate_to),
+            std::forward<AnotherMapBuilder>(another_map_builder)};
+  }
+
   inline auto count() {
-    return aggregate(size_t(0), [](auto& cnt, auto&&) { ++cnt; });
+    return aggregate(size_t(0), GroupCounter{});
   }
 
   inline auto to_vector() {
     return aggregate(ContainerBuilder<std::vector>{}, DefaultContainerInserter::value);
   }
 
+  // Each group is a `HyperLogLog` sketch of the values, see `approx_count_distinct`.
+  inline auto approx_count_distinct(size_t precision = HyperLogLog::DefaultPrecision) {
+    return aggregate(HyperLogLog(precision), [](auto& hll, auto&& v) { hll.add(v); });
+  }
+
+  // Each group is a `KllSketch` of the values, see `quantiles`.
+  inline auto quantiles(size_t k = kll_sketch_utils::DefaultK) {
+    return aggregate([k](auto type) {
+      return KllSketch<typename decltype(type)::type>(k);
+    }, [](auto& kll, auto&& v) {
+      kll.add(std::forward<decltype(v)>(v));
+    });
+  }
+
+  // Aggregate the groups by `num_threads` threads, see `ParallelGroupBy`.
+  inline ParallelGroupByArgs<GroupByArgs, NullArg> parallel(size_t num_threads) {
+    static_assert(!Adjacenct, "Adjacent groupby cannot be parallelized.");
+    return {*this, std::max<size_t>(num_threads, 1)};
+  }
+
+
   // used by operator
   constexpr static bool is_adjacent = Adjacenct;
+  constexpr static bool is_cache_by_ref = CacheByRef;
+  using AggregateToType = AggregateTo;
 
   template<typename Input>
   using KeyType = traits::remove_cvr_t<typename traits::invocation<KeyBy, traits::remove_vr_t<Input>&>::result_t>;
@@ -91,6 +158,11 @@ struct GroupByArgs {
     return traits::is_builder<Aggregator, Elem>::value;
   }
 
+  template<typename K, typename V>
+  inline auto make_map() {
+    return map_builder(Type<K>{}, Type<V>{});
+  }
+
   template<typename Input, typename Elem = ROV<Input>>
   inline decltype(auto) get_aggregator() {
     if constexpr (traits::is_builder<Aggregator, Elem>::value) {
@@ -99,6 +171,39 @@ struct GroupByArgs {
       return aggregator;
     }
   }
+
+  // the value of each group in the map, which is the value of the last element if there is no aggregator
+  template<typename Input>
+  using GroupType = std::conditional_t<std::is_same<Aggregator, NullArg>::value,
+    ValueType<Input>,
+    decltype(std::declval<GroupByArgs&>().template get_aggregator<Input>())
+  >;
+
+  // aggregate the element `e` with key `key` to `map`, and return the (key, group) pair in `map`
+  template<typename Input, typename Map, typename K, typename E>
+  inline auto& update(Map& map, K&& key, E& e) {
+    if constexpr (std::is_same<Aggregator, NullArg>::value) {
+      auto iter = map.find(key);
+      if (iter == map.end()) {
+        iter = map.emplace(std::forward<K>(key), valby(e)).first;
+      } else {
+        auto val = valby(e);
+        iter->second = std::forward<decltype(val)>(val);
+      }
+      return *iter;
+    } else if constexpr (is_builder<Input>()) {
+      auto iter = map.find(key);
+      if (iter == map.end()) {
+        iter = map.emplace(std::forward<K>(key), get_aggregator<Input>()).first;
+      }
+      aggregate_to(iter->second, valby(e));
+      return *iter;
+    } else {
+      auto iter = map.try_emplace(std::forward<K>(key)).first;
+      aggregate_to(iter->second, valby(e));
+      return *iter;
+    }
+  }
 };
 
 template<typename KeyBy>
@@ -119,38 +224,455 @@ template<typename Parent, typename Args,
 inline auto operator | (Parent&& parent, Args&& args) {
   using InputType = typename P::OutputType;
   using KeyType = typename A::template KeyType<InputType>;
-  if constexpr (std::is_same_v<typename A::AggregatorType, NullArg>) {
-    using ValType = decltype(std::declval<A&>().valby(std::declval<InputType>()));
-    return parent | aggregate(std::unordered_map<KeyType, ValType>{},
-                      [&](auto& map, InputType e) {
-                        auto key = args.keyby(e);
-                        auto iter = map.find(key);
-                        if (iter == map.end()) {
-                          map.emplace(std::forward<decltype(key)>(key), args.valby(e));
-                        } else {
-                          auto val = args.valby(e);
-                          iter->second = std::forward<decltype(val)>(val);
-                        }
-                      });
-  } else {
-    using ValType = decltype(std::declval<A&>().template get_aggregator<InputType>());
-    if constexpr (A::template is_builder<InputType>()) {
-      return parent | aggregate(std::unordered_map<KeyType, ValType>(),
-                        [&](auto& map, InputType e) {
-                          auto&& key = args.keyby(e);
-                          auto iter = map.find(key);
-                          if (iter == map.end()) {
-                            iter = map.emplace(key, args.template get_aggregator<InputType>()).first;
-                          }
-                          args.aggregate_to(iter->second, args.valby(e));
-                        });
+  using ValType = typename A::template GroupType<InputType>;
+  return parent | aggregate(args.template make_map<KeyType, ValType>(),
+                    [&](auto& map, InputType e) {
+                      args.template update<InputType>(map, args.keyby(e), e);
+                    });
+}
+
+struct ParallelGroupByArgsTag {};
+
+template<typename GroupByArgsType, typename Combiner>
+struct ParallelGroupByArgs {
+  using TagType = ParallelGroupByArgsTag;
+  using GroupByType = GroupByArgsType;
+
+  GroupByArgsType groupby_args;
+  size_t parallelism;
+  Combiner combiner{};
+  // the number of elements sent to a thread at a time
+  size_t batch_size = 1024;
+  ExecutorPool* executor_pool = nullptr;
+
+  // used by user
+  // [](auto& group, auto&& another_group) -> void {
+  //   To combine the aggregated another_group of the same key into group;
+  // }
+  template<typename AnotherCombiner>
+  inline ParallelGroupByArgs<GroupByArgsType, AnotherCombiner> combine(AnotherCombiner another_combiner) {
+    return {
+      std::forward<GroupByArgsType>(groupby_args),
+      parallelism,
+      std::forward<AnotherCombiner>(another_combiner),
+      batch_size,
+      executor_pool
+    };
+  }
+
+  inline ParallelGroupByArgs& batch(size_t size) {
+    batch_size = std::max<size_t>(size, 1);
+    return *this;
+  }
+
+  // The threads are leased from `pool`, or from `parallel_utils::default_executor_pool()` by default.
+  inline ParallelGroupByArgs& execute_by(ExecutorPool& pool) {
+    executor_pool = &pool;
+    return *this;
+  }
+
+  // used by operator
+  inline ExecutorPool& get_executor_pool() {
+    if (!executor_pool) {
+      return parallel_utils::default_executor_pool();
+    }
+    return *executor_pool;
+  }
+
+  template<typename V>
+  inline void combine_groups(V& group, V&& another_group) {
+    using Aggregator = typename GroupByArgsType::AggregatorType;
+    using AggregateTo = traits::remove_cvr_t<typename GroupByArgsType::AggregateToType>;
+    if constexpr (!std::is_same<Combiner, NullArg>::value) {
+      combiner(group, std::move(another_group));
+    } else if constexpr (std::is_same<Aggregator, NullArg>::value) {
+      // the value of one of the last elements
+      group = std::move(another_group);
+    } else if constexpr (std::is_same<AggregateTo, GroupCounter>::value) {
+      group += another_group;
+    } else if constexpr (std::is_same<AggregateTo, traits::remove_cvr_t<DefaultContainerInserter::type>>::value) {
+      for (auto& e : another_group) {
+        container_utils::insert(group, std::move(e));
+      }
+    } else if constexpr (traits::has_merge<V>::value) {
+      group.merge(another_group);
     } else {
-      return parent | aggregate(std::unordered_map<KeyType, ValType>(),
-                        [&](auto& map, InputType e) {
-                          args.aggregate_to(map[args.keyby(e)], args.valby(e));
-                        });
+      static_assert(!std::is_same<V, V>::value,
+        "Parallel groupby requires `combine(combiner)` to combine the groups aggregated by different threads.");
+    }
+  }
+};
+
+/**
+ * Groupby by multiple threads leased from an `ExecutorPool` (see `execute_by`) in two phases.
+ * 1. The inputs are sent to the threads in batches, and each thread aggregates the elements into its own maps,
+ *    one map per partition of the keys by hash. The input thread blocks if the threads fall behind.
+ * 2. Once all the inputs are aggregated, the i-th thread combines the groups in the i-th partition of all the threads.
+ *    Combining is by `combine(combiner)`, or is deduced for `count()`, `to_vector()`, groupby without aggregator,
+ *    and aggregators that have `merge`.
+ * At last, the partitions, which have no common keys, are moved into the result map.
+ *
+ * The elements are copied into the batches, or referenced if `cache_by_ref()`.
+ * Without aggregator, each group keeps a copy of the value of one of its last elements.
+ **/
+template<typename Parent, typename Args>
+struct ParallelGroupBy {
+  using InputType = typename traits::remove_cvr_t<Parent>::OutputType;
+  using GroupByArgsType = typename Args::GroupByType;
+  using KeyType = typename GroupByArgsType::template KeyType<InputType>;
+  using GroupType = std::conditional_t<std::is_same<typename GroupByArgsType::AggregatorType, NullArg>::value,
+    typename GroupByArgsType::template ROV<InputType>,
+    typename GroupByArgsType::template GroupType<InputType>
+  >;
+  using MapType = decltype(std::declval<GroupByArgsType&>().template make_map<KeyType, GroupType>());
+  using ElemType = std::conditional_t<GroupByArgsType::is_cache_by_ref,
+    Reference<traits::remove_vr_t<InputType>>,
+    traits::remove_cvr_t<InputType>
+  >;
+  using BatchType = std::vector<ElemType>;
+  // the number of batches queued for each thread
+  constexpr static size_t QueueCapacity = 8;
+
+  Parent parent;
+  Args args;
+
+  struct Execution : public ExecutionBase {
+    struct Worker {
+      // one map per partition
+      std::vector<MapType> maps;
+    };
+
+    Args args;
+    auto_val(ctrl, default_control());
+    std::vector<Worker> workers;
+    ExecutorPool::Lease lease;
+    BatchType batch;
+    // the batches not taken by the workers yet, and whether there will be no more batches
+    std::mutex mutex;
+    std::condition_variable batch_pushed;
+    std::condition_variable batch_popped;
+    std::deque<BatchType> batches;
+    bool input_ended = false;
+    MapType res = args.groupby_args.template make_map<KeyType, GroupType>();
+
+    Execution(const Args& args): args(args) {}
+
+    ~Execution() {
+      // in case the execution is dropped before `end`
+      close();
+      lease.release();
+    }
+
+    inline auto& control() {
+      return ctrl;
+    }
+
+    inline void start() {
+      if (args.parallelism == 1) {
+        return;
+      }
+      batch.reserve(args.batch_size);
+      workers.resize(args.parallelism);
+      lease = args.get_executor_pool().lease(args.parallelism);
+      for (size_t i = 0; i < args.parallelism; i++) {
+        lease.run(i, [this, i]() { aggregate(i); });
+      }
     }
+
+    inline void process(InputType e) {
+      if (args.parallelism == 1) {
+        args.groupby_args.template update<InputType>(res, args.groupby_args.keyby(e), e);
+        return;
+      }
+      if constexpr (GroupByArgsType::is_cache_by_ref) {
+        batch.emplace_back(e);
+      } else {
+        batch.emplace_back(std::forward<InputType>(e));
+      }
+      if (batch.size() >= args.batch_size) {
+        dispatch();
+      }
+    }
+
+    // send the batch to the workers, and block while all the workers have `QueueCapacity` batches to aggregate
+    inline void dispatch() {
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        batch_popped.wait(lock, [this]() { return batches.size() < QueueCapacity * workers.size(); });
+        batches.push_back(std::move(batch));
+      }
+      batch_pushed.notify_one();
+      batch = BatchType();
+      batch.reserve(args.batch_size);
+    }
+
+    inline void close() {
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        input_ended = true;
+      }
+      batch_pushed.notify_all();
+    }
+
+    inline void end() {
+      if (args.parallelism == 1) {
+        return;
+      }
+      if (!batch.empty()) {
+        dispatch();
+      }
+      close();
+      // the groups of a partition are combined once all the workers finish aggregation
+      lease.wait();
+      for (size_t i = 0; i < workers.size(); i++) {
+        lease.run(i, [this, i]() { combine(i); });
+      }
+      lease.release();
+      res = std::move(workers[0].maps[0]);
+      for (size_t i = 1; i < workers.size(); i++) {
+        for (auto& kv : workers[i].maps[i]) {
+          res.try_emplace(kv.first, std::move(kv.second));
+        }
+      }
+      workers.clear();
+    }
+
+    inline size_t partition(const KeyType& key) const {
+      // take the upper bits of a multiplicative hash, which are unrelated to the lower bits used by hash maps
+      return (uint64_t(std::hash<KeyType>{}(key)) * 0x9E3779B97F4A7C15ULL >> 32) % workers.size();
+    }
+
+    void aggregate(size_t id) {
+      auto& worker = workers[id];
+      // each thread uses its own copy of the user functions
+      auto groupby_args = args.groupby_args;
+      for (size_t i = 0; i < workers.size(); i++) {
+        worker.maps.push_back(groupby_args.template make_map<KeyType, GroupType>());
+      }
+      while (true) {
+        BatchType b;
+        {
+          std::unique_lock<std::mutex> lock(mutex);
+          batch_pushed.wait(lock, [this]() { return !batches.empty() || input_ended; });
+          if (batches.empty()) {
+            break;
+          }
+          b = std::move(batches.front());
+          batches.pop_front();
+        }
+        batch_popped.notify_one();
+        for (auto& elem : b) {
+          auto& e = [&]() -> decltype(auto) {
+            if constexpr (GroupByArgsType::is_cache_by_ref) {
+              return *elem;
+            } else {
+              return (elem);
+            }
+          }();
+          auto&& key = groupby_args.keyby(e);
+          groupby_args.template update<InputType>(worker.maps[partition(key)],
+            std::forward<decltype(key)>(key), e);
+        }
+      }
+    }
+
+    // combine the groups of partition `id` of all the workers
+    void combine(size_t id) {
+      auto& combined = workers[id].maps[id];
+      for (size_t i = 0; i < workers.size(); i++) {
+        if (i == id) {
+          continue;
+        }
+        for (auto& kv : workers[i].maps[id]) {
+          auto iter = combined.find(kv.first);
+          if (iter == combined.end()) {
+            combined.try_emplace(kv.first, std::move(kv.second));
+          } else {
+            args.combine_groups(iter->second, std::move(kv.second));
+          }
+        }
+      }
+    }
+
+    inline auto& result() {
+      return res;
+    }
+
+    template<typename Exec, typename ... ArgT>
+    static auto execute(ArgT&& ... args) {
+      Exec exec(std::forward<ArgT>(args)...);
+      exec.start();
+      exec.run();
+      exec.end();
+      return std::move(exec.result());
+    }
+  };
+
+  inline decltype(auto) execute() {
+    return parent.template wrap<ExecutionType::Execute, Execution, Args&>(args);
   }
+};
+
+template<typename Parent, typename Args,
+  typename P = traits::remove_cvr_t<Parent>,
+  typename A = traits::remove_cvr_t<Args>,
+  std::enable_if_t<std::is_same<typename A::TagType, ParallelGroupByArgsTag>::value>* = nullptr,
+  std::enable_if_t<traits::is_pipe_operator<P>::value>* = nullptr>
+inline decltype(auto) operator | (Parent&& parent, Args&& args) {
+  return ParallelGroupBy<P, A>{
+    std::forward<Parent>(parent), std::forward<Args>(args)
+  }.execute();
+}
+
+struct ExternalGroupByArgsTag {};
+
+template<typename GroupByArgsType, typename SizeOf>
+struct ExternalGroupByArgs {
+  using TagType = ExternalGroupByArgsTag;
+  using GroupByType = GroupByArgsType;
+
+  GroupByArgsType groupby_args;
+  size_t memory_budget;
+  std::string spill_directory{};
+  SizeOf size_of{};
+
+  // The directory of the temporary files, which is `std::filesystem::temp_directory_path()` by default.
+  inline ExternalGroupByArgs& spill_dir(const std::string& dir) {
+    spill_directory = dir;
+    return *this;
+  }
+};
+
+/**
+ * Aggregate the groups of `groupby_args`, e.g., `external_groupby(groupby(...).count(), bytes)`,
+ * with at most about `bytes` of groups in memory, see `ExternalGroupBy`.
+ * Unlike `groupby`, which returns the map, the groups are output as (key, group) pairs.
+ **/
+template<typename GroupByArgsType>
+inline ExternalGroupByArgs<GroupByArgsType, spill_utils::EstimatedSize>
+external_groupby(GroupByArgsType groupby_args, size_t bytes) {
+  return external_groupby(std::move(groupby_args), bytes, spill_utils::EstimatedSize{});
+}
+
+// `size_of(key, group)` estimates the bytes of a group in memory, e.g., including the heap memory of its elements.
+template<typename GroupByArgsType, typename SizeOf>
+inline ExternalGroupByArgs<GroupByArgsType, SizeOf>
+external_groupby(GroupByArgsType groupby_args, size_t bytes, SizeOf size_of) {
+  static_assert(std::is_same<typename GroupByArgsType::TagType, GroupByArgsTag>::value,
+    "External groupby expects the arguments of `groupby`.");
+  static_assert(!GroupByArgsType::is_adjacent, "Adjacent groupby keeps only one group in memory.");
+  static_assert(!GroupByArgsType::is_cache_by_ref, "Spilled elements cannot be cached by reference.");
+  return {std::move(groupby_args), std::max<size_t>(bytes, 1), {}, std::forward<SizeOf>(size_of)};
+}
+
+/**
+ * Groupby with a bounded map, which outputs (key, group) pairs instead of returning the map.
+ * The size of the map is the sum of the sizes of the (key, group) pairs estimated by `size_of`, which is updated
+ * whenever a group is updated. By default, it counts the memory allocated by string and container keys and groups,
+ * but not the memory owned by their elements (see `spill_utils::estimated_size`), which needs a custom `size_of`.
+ * The memory is only bounded as well as the estimation.
+ * Once the map reaches `bytes`, the elements of the keys not in the map are written to
+ * on-disk buckets by the hashes of the keys (see `spill_utils::SpillBuckets`).
+ * At the end, the groups in the map are output, and then each bucket is aggregated in the same way.
+ *
+ * The elements of a key are aggregated in the order of their arrival, so the groups are the same as
+ * the ones of the map returned by `groupby`, but are output in a different order.
+ * Without aggregator, each group keeps a copy of the value of the last element.
+ **/
+template<typename Parent, typename Args>
+struct ExternalGroupBy {
+  using InputType = typename traits::remove_cvr_t<Parent>::OutputType;
+  using GroupByArgsType = typename Args::GroupByType;
+  using KeyType = typename GroupByArgsType::template KeyType<InputType>;
+  using GroupType = traits::remove_cvr_t<typename GroupByArgsType::template GroupType<InputType>>;
+  using MapType = decltype(std::declval<GroupByArgsType&>().template make_map<KeyType, GroupType>());
+  using ElemType = traits::remove_cvr_t<InputType>;
+  using OutputType = std::pair<KeyType, GroupType>;
+
+  Parent parent;
+  Args args;
+
+  template<typename Child>
+  struct Execution : public Child {
+    template<typename ... X>
+    Execution(const Args& args, X&& ... x):
+      Child(std::forward<X>(x)...),
+      args(args) {
+    }
+
+    Args args;
+    MapType map = args.groupby_args.template make_map<KeyType, GroupType>();
+    // the estimated bytes of the groups in `map`
+    size_t map_bytes = 0;
+    spill_utils::SpillBuckets<ElemType> buckets{args.spill_directory, 0};
+
+    inline void process(InputType e) {
+      update(buckets, e);
+    }
+
+    template<typename E>
+    inline void update(spill_utils::SpillBuckets<ElemType>& spilled, E& e) {
+      auto&& key = args.groupby_args.keyby(e);
+      auto iter = map.find(key);
+      if (iter != map.end()) {
+        map_bytes -= args.size_of(iter->first, iter->second);
+      } else if (map_bytes >= args.memory_budget && spilled.can_spill()) {
+        spilled.write(std::hash<KeyType>{}(key), e);
+        return;
+      }
+      auto& group = args.groupby_args.template update<InputType>(map, std::forward<decltype(key)>(key), e);
+      map_bytes += args.size_of(group.first, group.second);
+    }
+
+    inline void end() {
+      drain(buckets);
+      Child::end();
+    }
+
+    // output the groups in the map and then the ones of the spilled buckets
+    void drain(spill_utils::SpillBuckets<ElemType>& spilled) {
+      for (auto& kv : map) {
+        Child::process(OutputType{kv.first, std::move(kv.second)});
+        if (unlikely(Child::control().break_now)) {
+          return;
+        }
+      }
+      map.clear();
+      map_bytes = 0;
+      for (auto& file : spilled.finish()) {
+        spill_utils::SpillBuckets<ElemType> next(args.spill_directory, spilled.next_level());
+        auto reader = file.reader();
+        ElemType e;
+        while (reader.next(e)) {
+          update(next, e);
+        }
+        drain(next);
+        if (unlikely(Child::control().break_now)) {
+          return;
+        }
+      }
+    }
+  };
+
+  template<ExecutionType ET, typename Child, typename ... X>
+  inline decltype(auto) wrap(X&& ... x) {
+    using Ctrl = traits::operator_control_t<Child>;
+    static_assert(!Ctrl::is_reversed,
+      "External groupby operator does not support reversion. Use `with_buffer()` for the nearest `reverse`");
+    return parent.template wrap<ET, Execution<Child>, Args&, X...>(
+      args, std::forward<X>(x)...
+    );
+  }
+};
+
+template<typename Parent, typename Args,
+  typename P = traits::remove_cvr_t<Parent>,
+  typename A = traits::remove_cvr_t<Args>,
+  std::enable_if_t<std::is_same<typename A::TagType, ExternalGroupByArgsTag>::value>* = nullptr,
+  std::enable_if_t<traits::is_pipe_operator<P>::value>* = nullptr>
+inline ExternalGroupBy<P, A>
+operator | (Parent&& parent, Args&& args) {
+  return {std::forward<Parent>(parent), std::forward<Args>(args)};
 }
 
 // Override for adjacenct groupby
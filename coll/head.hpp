@@ -68,7 +68,13 @@ template<typename Parent, typename Args,
   std::enable_if_t<std::is_same<typename A::TagType, HeadArgsTag>::value>* = nullptr,
   std::enable_if_t<traits::is_pipe_operator<P>::value>* = nullptr>
 inline decltype(auto) operator | (Parent&& parent, Args&& args) {
-  return Head<P, A>{std::forward<Parent>(parent), std::forward<Args>(args)}.head();
+  if constexpr (traits::has_limit<P>::value) {
+    P limited(std::forward<Parent>(parent));
+    limited.limit(1);
+    return Head<P, A>{std::move(limited), std::forward<Args>(args)}.head();
+  } else {
+    return Head<P, A>{std::forward<Parent>(parent), std::forward<Args>(args)}.head();
+  }
 }
 } // namespace coll
 
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <vector>
+
+namespace coll {
+/**
+ * A HyperLogLog sketch that estimates the number of distinct elements with 2^precision one-byte registers.
+ * The relative standard error is about 1.04 / sqrt(2^precision), e.g., 1.6% for the default precision 12 (4KB).
+ *
+ * Elements are hashed by `std::hash` and then mixed, as `std::hash` of integers is identity.
+ * Sketches of the same precision can be merged, e.g., the partial sketches of parallel groupby.
+ **/
+class HyperLogLog {
+public:
+  constexpr static size_t MinPrecision = 4;
+  constexpr static size_t MaxPrecision = 18;
+  constexpr static size_t DefaultPrecision = 12;
+
+  explicit HyperLogLog(size_t precision = DefaultPrecision):
+    precision(std::clamp(precision, MinPrecision, MaxPrecision)),
+    registers(size_t(1) << this->precision, 0) {
+  }
+
+  template<typename T>
+  inline void add(const T& e) {
+    add_hash(std::hash<T>{}(e));
+  }
+
+  inline void add_hash(uint64_t h) {
+    h = mix(h);
+    auto idx = h >> (64 - precision);
+    // the rank of the first 1 bit in the remaining bits, which is at most 64 - precision + 1
+    auto rest = (h << precision) | (uint64_t(1) << (precision - 1));
+    registers[idx] = std::max(registers[idx], uint8_t(__builtin_clzll(rest) + 1));
+  }
+
+  // merge `other` into this sketch, which then estimates the distinct elements of both
+  inline void merge(const HyperLogLog& other) {
+    if (other.precision != precision) {
+      throw std::invalid_argument("Cannot merge HyperLogLog sketches of different precisions.");
+    }
+    for (size_t i = 0; i < registers.size(); i++) {
+      registers[i] = std::max(registers[i], other.registers[i]);
+    }
+  }
+
+  size_t estimate() const {
+    const double m = registers.size();
+    double sum = 0;
+    size_t num_zeros = 0;
+    for (auto r : registers) {
+      sum += std::ldexp(1.0, -int(r));
+      num_zeros += r == 0;
+    }
+    double alpha = m == 16 ? 0.673 : m == 32 ? 0.697 : m == 64 ? 0.709 : 0.7213 / (1 + 1.079 / m);
+    double e = alpha * m * m / sum;
+    // linear counting for small cardinalities
+    if (e <= 2.5 * m && num_zeros != 0) {
+      e = m * std::log(m / num_zeros);
+    }
+    return size_t(e + 0.5);
+  }
+
+  inline size_t get_precision() const { return precision; }
+
+  inline void clear() {
+    std::fill(registers.begin(), registers.end(), 0);
+  }
+
+  friend bool operator==(const HyperLogLog& a, const HyperLogLog& b) {
+    return a.precision == b.precision && a.registers == b.registers;
+  }
+
+private:
+  // the finalizer of MurmurHash3
+  static inline uint64_t mix(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+  }
+
+  size_t precision;
+  std::vector<uint8_t> registers;
+};
+} // namespace coll
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <iterator>
+#include <vector>
+
 #include "base.hpp"
 #include "traits.hpp"
 #include "triggers.hpp"
@@ -40,6 +43,23 @@ struct IterateByIterator {
     }
   };
 
+  // Split into `n` consecutive sub-ranges with (almost) the same number of elements.
+  // Used by `parallel` to let each executor iterate a sub-range by itself.
+  template<typename It = Iter,
+    std::enable_if_t<std::is_base_of<std::random_access_iterator_tag,
+      typename std::iterator_traits<It>::iterator_category>::value>* = nullptr>
+  std::vector<IterateByIterator<Iter>> split(size_t n) const {
+    size_t size = right - left;
+    std::vector<IterateByIterator<Iter>> iters;
+    iters.reserve(n);
+    for (size_t i = 0, begin = 0; i < n; i++) {
+      size_t end = begin + size / n + (i < size % n);
+      iters.push_back({left + begin, left + end});
+      begin = end;
+    }
+    return iters;
+  }
+
   template<ExecutionType ET, typename Child, typename ... X>
   inline decltype(auto) wrap(X&& ... x) {
     if constexpr (ET == Construct) {
@@ -0,0 +1,186 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace coll {
+namespace kll_sketch_utils {
+constexpr size_t DefaultK = 200;
+} // namespace kll_sketch_utils
+
+/**
+ * A KLL sketch (Karnin, Lang and Liberty) that estimates the quantiles of a stream in O(k log(n / k)) memory.
+ * The rank error is about 1.65 / k with high probability, e.g., 0.8% for the default k = 200.
+ *
+ * The elements are kept in levels of compactors, where an element of level h stands for 2^h inputs.
+ * When a compactor is full, it is sorted and every other element, starting from a random one of the first two,
+ * is promoted to the next level, whose capacity is larger by 1.5x.
+ * The minimum and the maximum are kept exactly as the 0- and 1-quantiles.
+ * Sketches of the same `Compare` can be merged, e.g., the partial sketches of parallel groupby.
+ **/
+template<typename T, typename Compare = std::less<T>>
+class KllSketch {
+public:
+  explicit KllSketch(size_t k = kll_sketch_utils::DefaultK, const Compare& compare = Compare()):
+    k(std::max<size_t>(k, 8)),
+    compare(compare) {
+    grow();
+  }
+
+  template<typename U>
+  inline void add(U&& e) {
+    update_min_max(e);
+    compactors[0].emplace_back(std::forward<U>(e));
+    ++num_retained;
+    ++n;
+    if (num_retained >= max_retained) {
+      compress();
+    }
+  }
+
+  // merge `other` into this sketch, which then summarizes the inputs of both
+  void merge(const KllSketch& other) {
+    if (other.empty()) {
+      return;
+    }
+    update_min_max(*other.min_item);
+    update_min_max(*other.max_item);
+    while (compactors.size() < other.compactors.size()) {
+      grow();
+    }
+    for (size_t h = 0; h < other.compactors.size(); h++) {
+      compactors[h].insert(compactors[h].end(), other.compactors[h].begin(), other.compactors[h].end());
+    }
+    num_retained += other.num_retained;
+    n += other.n;
+    while (num_retained >= max_retained) {
+      compress();
+    }
+  }
+
+  // the estimated q-quantiles for q in [0, 1], or an empty vector if there are no inputs
+  std::vector<T> quantiles(const std::vector<double>& qs) const {
+    std::vector<T> res;
+    if (n == 0) {
+      return res;
+    }
+    auto items = weighted_items();
+    uint64_t total = 0;
+    for (auto& i : items) {
+      total += i.second;
+      i.second = total;
+    }
+    res.reserve(qs.size());
+    for (auto q : qs) {
+      if (q <= 0) {
+        res.push_back(*min_item);
+        continue;
+      }
+      if (q >= 1) {
+        res.push_back(*max_item);
+        continue;
+      }
+      auto rank = uint64_t(std::ceil(q * total));
+      auto iter = std::lower_bound(items.begin(), items.end(), std::max<uint64_t>(rank, 1),
+        [](auto& item, uint64_t r) { return item.second < r; });
+      res.push_back(iter == items.end() ? items.back().first : iter->first);
+    }
+    return res;
+  }
+
+  inline T quantile(double q) const {
+    return quantiles({q}).at(0);
+  }
+
+  // the number of inputs
+  inline uint64_t size() const { return n; }
+  inline bool empty() const { return n == 0; }
+  inline size_t num_retained_items() const { return num_retained; }
+
+private:
+  // the capacity of level h, which shrinks by 2/3 per level from the top one of capacity k
+  inline size_t capacity(size_t h) const {
+    auto depth = compactors.size() - h - 1;
+    return size_t(std::ceil(std::pow(2.0 / 3.0, depth) * k)) + 1;
+  }
+
+  void grow() {
+    compactors.emplace_back();
+    max_retained = 0;
+    for (size_t h = 0; h < compactors.size(); h++) {
+      max_retained += capacity(h);
+    }
+  }
+
+  // compact the lowest full level into the next level
+  void compress() {
+    for (size_t h = 0; h < compactors.size(); h++) {
+      if (compactors[h].size() >= capacity(h)) {
+        if (h + 1 == compactors.size()) {
+          grow();
+        }
+        auto& level = compactors[h];
+        auto& next = compactors[h + 1];
+        std::sort(level.begin(), level.end(), compare);
+        // keep the last element if the number of elements is odd
+        size_t num_pairs = level.size() / 2;
+        for (size_t i = flip(); i < num_pairs * 2; i += 2) {
+          next.push_back(std::move(level[i]));
+        }
+        level.erase(level.begin(), level.begin() + num_pairs * 2);
+        num_retained -= num_pairs;
+        if (num_retained < max_retained) {
+          break;
+        }
+      }
+    }
+  }
+
+  inline void update_min_max(const T& e) {
+    if (!min_item || compare(e, *min_item)) {
+      min_item = e;
+    }
+    if (!max_item || compare(*max_item, e)) {
+      max_item = e;
+    }
+  }
+
+  // a random bit by xorshift, whose fixed seed makes the sketch deterministic
+  inline size_t flip() {
+    seed ^= seed << 13;
+    seed ^= seed >> 7;
+    seed ^= seed << 17;
+    return seed & 1;
+  }
+
+  // the retained elements sorted, each with its weight
+  std::vector<std::pair<T, uint64_t>> weighted_items() const {
+    std::vector<std::pair<T, uint64_t>> items;
+    items.reserve(num_retained);
+    for (size_t h = 0; h < compactors.size(); h++) {
+      for (auto& e : compactors[h]) {
+        items.emplace_back(e, uint64_t(1) << h);
+      }
+    }
+    std::sort(items.begin(), items.end(), [&](auto& a, auto& b) {
+      return compare(a.first, b.first);
+    });
+    return items;
+  }
+
+  size_t k;
+  Compare compare;
+  std::vector<std::vector<T>> compactors;
+  size_t num_retained = 0;
+  size_t max_retained = 0;
+  uint64_t n = 0;
+  std::optional<T> min_item;
+  std::optional<T> max_item;
+  uint64_t seed = 0x9E3779B97F4A7C15ULL;
+};
+} // namespace coll
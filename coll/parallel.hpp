@@ -1,23 +1,55 @@
 #pragma once
 #if ENABLE_PARALLEL
 
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+#include <memory>
+#include <thread>
 #include <vector>
 
 #include "base.hpp"
+#include "executor_pool.hpp"
 #include "place_holder.hpp"
 #include "shuffle_strategy.hpp"
+#include "spsc_queue.hpp"
 #include "utils.hpp"
 
 #include "foreach.hpp"
+#include "take_while.hpp"
 
 namespace coll {
 namespace parallel_utils {
-static zaf::ActorSystem actor_system;
+template<typename S, typename E>
+auto has_select_impl(int) -> decltype(
+  std::declval<S&>().select(std::declval<E&>(), size_t(0)),
+  std::true_type{}
+);
+
+template<typename S, typename E>
+std::false_type has_select_impl(...);
+
+// whether the shuffle strategy decides the executor of an element by itself
+template<typename S, typename E>
+using has_select = decltype(has_select_impl<S, E>(0));
+
+template<typename P>
+auto has_split_impl(int) -> decltype(
+  std::declval<P&>().split(size_t(0)).size(),
+  std::true_type{}
+);
+
+template<typename P>
+std::false_type has_split_impl(...);
+
+// whether the source operator can be split into sub-sources, e.g., `Range` and `IterateByIterator` of random access iterators
+template<typename P>
+using has_split = decltype(has_split_impl<P>(0));
 } // namespace parallel_utils
 
 struct ParallelArgsTag {};
 
-template<typename PipelineBuilder, typename ShuffleStrat>
+template<typename PipelineBuilder, typename ShuffleStrat, bool UseChannels = false, bool Ordered = false>
 struct ParallelArgs {
   using TagType = ParallelArgsTag;
 
@@ -30,6 +62,15 @@ struct ParallelArgs {
   PipelineBuilder pipeline_builder;
   ShuffleStrat shuffle_strategy;
   zaf::ActorGroup* actor_group = nullptr;
+  ExecutorPool* executor_pool = nullptr;
+  // the max number of elements packed into one message, 1 means no batching
+  size_t batch_size = 1;
+  // the capacity of each SPSC channel, used only if UseChannels
+  size_t channel_capacity = 0;
+  // the max number of inputs whose outputs are not yet emitted, used only if Ordered
+  size_t reorder_capacity = 0;
+  // the max number of messages sent to but not yet processed by each executor, 0 means unlimited
+  size_t in_flight_limit = 0;
 
   template<typename Input>
   using PipelineType = typename traits::invocation<
@@ -37,10 +78,17 @@ struct ParallelArgs {
   >::result_t;
 
   zaf::ActorGroup& get_actor_group() {
-    if (!actor_group) {
-      return parallel_utils::actor_system;
+    if (actor_group) {
+      return *actor_group;
     }
-    return *actor_group;
+    return get_executor_pool().actor_group();
+  }
+
+  ExecutorPool& get_executor_pool() {
+    if (!executor_pool) {
+      return parallel_utils::default_executor_pool();
+    }
+    return *executor_pool;
   }
 
   auto& execute_by(zaf::ActorGroup& group) {
@@ -48,15 +96,77 @@ struct ParallelArgs {
     return *this;
   }
 
+  // The executors are taken from `pool`, which can be shared by multiple parallel operators and pipelines
+  auto& execute_by(ExecutorPool& pool) {
+    executor_pool = &pool;
+    return *this;
+  }
+
+  // Elements sent to each executor, and results sent back from each executor,
+  // are packed into batches of (at most) `size` elements.
+  auto& batch(size_t size) {
+    batch_size = std::max<size_t>(size, 1);
+    return *this;
+  }
+
   template<typename NewShuffleStrat>
-  ParallelArgs<PipelineBuilder, NewShuffleStrat> shuffle_by(NewShuffleStrat&& strat) {
+  ParallelArgs<PipelineBuilder, NewShuffleStrat, UseChannels, Ordered> shuffle_by(NewShuffleStrat&& strat) {
     return {
       parallelism,
       pipeline_builder,
       std::forward<NewShuffleStrat>(strat),
-      actor_group
+      actor_group,
+      executor_pool,
+      batch_size,
+      channel_capacity,
+      reorder_capacity,
+      in_flight_limit
     };
   }
+
+  // Run the executors on dedicated threads that exchange elements with the operator
+  // through lock-free SPSC channels of `capacity` elements, instead of through actor messages.
+  ParallelArgs<PipelineBuilder, ShuffleStrat, true, Ordered> with_channels(size_t capacity = 4096) {
+    return {
+      parallelism,
+      pipeline_builder,
+      shuffle_strategy,
+      actor_group,
+      executor_pool,
+      batch_size,
+      std::max<size_t>(capacity, 1),
+      reorder_capacity,
+      in_flight_limit
+    };
+  }
+
+  // Emit the outputs in the order of their inputs. At most `capacity` inputs can be in flight,
+  // i.e., dispatched but their outputs are not yet emitted.
+  ParallelArgs<PipelineBuilder, ShuffleStrat, UseChannels, true> ordered(size_t capacity = 4096) {
+    return {
+      parallelism,
+      pipeline_builder,
+      shuffle_strategy,
+      actor_group,
+      executor_pool,
+      batch_size,
+      channel_capacity,
+      std::max<size_t>(capacity, 1),
+      in_flight_limit
+    };
+  }
+
+  // Block the operator, while emitting the outputs received, once an executor has `limit` messages
+  // (i.e., elements, batches or chunks) that are sent to it but not yet processed,
+  // so that the memory stays bounded when the executors are slower than the parent.
+  auto& max_in_flight(size_t limit) {
+    in_flight_limit = limit;
+    return *this;
+  }
+
+  // used by operator
+  constexpr static bool use_channels = UseChannels;
+  constexpr static bool is_ordered = Ordered;
 };
 
 template<typename PipelineBuilder>
@@ -73,14 +183,47 @@ parallel(size_t parallelism, PipelineBuilder builder) {
  * 3. The pipeline ends with a pipe operator
  *    + Parallel outputs every elements at the end of the pipeline
  *
- * If the actors `end` by themselves, remaining inputs from the parents will be ignored
  * The effect of `end` from parent to the actors is carried out by in_queue
  * The effect of `end` from actors to child is carried out by out_queue
  *
- * The implementation uses an independent group of actors for execution. The actors are not shared with other parallel operators.
- * TODO(zzxx): support actor sharing
+ * With `batch(n)`, the elements are sent to the executors by `codes::DataBatch` in batches of `n`,
+ * and the outputs of the executors are sent back in the same way.
+ *
+ * With `shuffle_by(shuffle::WorkStealing(chunk_size))`, the elements are pushed in chunks to per-executor deques
+ * that are shared by the executors, and idle executors steal chunks from busy ones.
+ * It suits the pipelines whose cost per element varies a lot.
+ *
+ * With `with_channels(capacity)`, each executor runs on a dedicated thread and owns two SPSC channels,
+ * one for the inputs from the operator and one for the outputs to the operator. No actor is involved.
+ * The shuffle strategy decides the executor of each input if it can (e.g., `Partition`),
+ * otherwise inputs go to the next executor whose input channel is not full.
+ *
+ * If the parent is a splittable source (i.e., `Range`, or `IterateByIterator` of random access iterators)
+ * and the shuffle strategy is the default one, the source is split into one sub-source per executor.
+ * The executors iterate their own sub-sources on the workers of the executor pool, and no element is dispatched.
+ * The outputs are sent back by SPSC channels as in `with_channels`, so `batch()` and `max_in_flight()`
+ * have no effect. The source is not split if the actors are asked to execute by `execute_by(group)`.
+ *
+ * With `ordered(capacity)`, the inputs are tagged with sequence numbers and the executors report the outputs
+ * of each input. The outputs are put back into the order of their inputs by a reorder buffer of `capacity` slots,
+ * and the operator stops dispatching when the buffer is full. The outputs produced by the executors
+ * at their `end` are emitted after all the others.
+ *
+ * With `max_in_flight(limit)`, the executors acknowledge the messages they processed, and the operator
+ * stops dispatching and waits for outputs or acknowledgements once `limit` messages are in flight to an executor
+ * (or `limit * parallelism` messages in total, if the strategy does not decide the executors).
+ * `with_channels` is always bounded by the capacity of the channels.
+ *
+ * If an executor ends by itself, it notifies the operator and drops (or completes without outputs if ordered)
+ * its inputs afterwards, until the operator ends.
+ *
+ * The executors come from an `ExecutorPool` that is kept warm across executions and can be shared
+ * by multiple parallel operators, i.e., the pool given by `execute_by(pool)` or otherwise a process-wide default
+ * pool, so no thread is created or destroyed per execution. The actors of an executor pool share the threads
+ * of its actor engine, so the executors that block, e.g., on nested `parallel`s without channels, should
+ * execute by a pool with enough threads, or by an actor group given by `execute_by(group)`.
  **/
-template<typename Parent, typename Args>
+template<typename Parent, typename Args, bool Splittable = true>
 struct Parallel {
   using InputType = typename Parent::OutputType;
   using QueueInputType = traits::remove_cvr_t<InputType>;
@@ -95,6 +238,25 @@ struct Parallel {
     std::conditional_t<IsSinkWithRes , std::pair<size_t, typename traits::remove_cvr_t<typename traits::execution_result_t<PipelineType, IsSinkWithRes>>>,
                 /* IsSinkWithoutRes */ size_t
   >>;
+  using OutputBatchType = std::vector<traits::remove_cvr_t<OutputType>>;
+
+  constexpr static bool IsOrdered = Args::is_ordered;
+  static_assert(!IsOrdered || IsPipeOperator,
+    "`ordered()` requires the pipeline of `parallel` to end with a pipe operator");
+  static_assert(!IsOrdered || !Args::use_channels,
+    "`ordered()` is not supported together with `with_channels()`");
+
+  // the elements sent to the executors, which are tagged with sequence numbers if ordered
+  using DispatchType = std::conditional_t<IsOrdered, shuffle::Sequenced<QueueInputType>, QueueInputType>;
+  // the sequence number of the outputs produced when an executor ends, which are not ordered
+  constexpr static size_t UnorderedSeq = size_t(-1);
+
+  // The outputs for consecutive inputs of an executor if ordered.
+  // The outputs of the input with sequence number `ends[i].first` ends at offset `ends[i].second` of `outputs`.
+  struct OrderedOutputBatch {
+    std::vector<std::pair<size_t, size_t>> ends;
+    OutputBatchType outputs;
+  };
 
   Parent parent;
   Args args;
@@ -113,27 +275,77 @@ struct Parallel {
       for (size_t i = 0; i < args.parallelism; i++) {
         executors[i] = actor_group.template spawn<ParallelExecutor>(this->args, i);
       }
-      shuffler.initialize(actor_group, executors);
+      if constexpr (IsOrdered) {
+        reorder_slots.resize(args.reorder_capacity);
+      }
+      shuffler.initialize(actor_group, executors, args.batch_size, args.in_flight_limit);
       Child::start();
     }
 
     Args args;
     unsigned num_termination = 0;
-    auto_val(shuffler, args.shuffle_strategy.template create<QueueInputType>());
+    size_t num_to_next_receive = args.batch_size;
+    auto_val(shuffler, args.shuffle_strategy.template create<DispatchType>());
     // typename Args::template ShuffleStratType<QueueInputType> shuffler = args.create();
 
+    // Sends the outputs of an executor to the res_collector, in batches if `batch_size` > 1
+    struct ResultSender {
+      ResultSender(zaf::ActorBehaviorX* this_actor, size_t batch_size):
+        this_actor(this_actor), batch_size(batch_size) {
+      }
+
+      zaf::ActorBehaviorX* this_actor;
+      size_t batch_size;
+      zaf::Actor res_collector;
+      std::conditional_t<IsOrdered, OrderedOutputBatch, OutputBatchType> batch;
+
+      template<typename U>
+      inline void send(U&& o) {
+        if constexpr (IsOrdered) {
+          batch.outputs.emplace_back(std::forward<U>(o));
+        } else if (batch_size <= 1) {
+          this_actor->send(res_collector, codes::Data, std::forward<U>(o));
+        } else {
+          batch.emplace_back(std::forward<U>(o));
+          if (batch.size() >= batch_size) {
+            flush();
+          }
+        }
+      }
+
+      // used if ordered, all the outputs of the input `seq` have been sent
+      inline void complete(size_t seq) {
+        batch.ends.emplace_back(seq, batch.outputs.size());
+        if (batch.ends.size() >= batch_size) {
+          flush();
+        }
+      }
+
+      inline void flush() {
+        if constexpr (IsOrdered) {
+          if (!batch.ends.empty()) {
+            this_actor->send(res_collector, codes::DataBatch, std::move(batch));
+            batch = OrderedOutputBatch{};
+          }
+        } else if (!batch.empty()) {
+          this_actor->send(res_collector, codes::DataBatch, std::move(batch));
+          batch = OutputBatchType{};
+          batch.reserve(batch_size);
+        }
+      }
+    };
+
     struct ParallelExecutor : public zaf::ActorBehaviorX {
       ParallelExecutor(Args& args, size_t pid):
         args(args), pid(pid) {
       }
 
       static auto ctor_partition_pipeline(Args& args, size_t pid,
-        [[maybe_unused]] zaf::ActorBehaviorX* this_actor,
-        [[maybe_unused]] zaf::Actor& res_collector) {
+        [[maybe_unused]] ResultSender& sender) {
         if constexpr (IsPipeOperator) {
           return args.pipeline_builder(pid, place_holder<QueueInputType&>())
-            | foreach([=, &res_collector](OutputType o) {
-                this_actor->send(res_collector, codes::Data, std::forward<OutputType>(o));
+            | foreach([&sender](OutputType o) {
+                sender.send(std::forward<OutputType>(o));
               });
         } else {
           return args.pipeline_builder(pid, place_holder<QueueInputType&>());
@@ -142,57 +354,204 @@ struct Parallel {
 
       Args& args;
       size_t pid;
-      zaf::Actor res_collector;
-      zaf::ActorBehaviorX* this_actor = this;
-      auto_val(partition_pipeline, ctor_partition_pipeline(args, pid, this_actor, res_collector));
-
-      void terminate() {
+      ResultSender sender{this, args.batch_size};
+      auto_val(partition_pipeline, ctor_partition_pipeline(args, pid, sender));
+      // whether the partition pipeline has ended
+      bool ended = false;
+      // the number of processed messages not yet acknowledged, used only if `in_flight_limit` > 0
+      size_t num_unacked = 0;
+      auto_val(ack_every, (args.in_flight_limit + 1) / 2);
+
+      // End the partition pipeline and notify the res_collector.
+      // The executor keeps taking inputs afterwards until terminated by the parent, such that
+      // the in-flight messages are still acknowledged. The inputs are dropped, or completed without
+      // outputs if ordered so that the res_collector does not wait for them.
+      void finish() {
+        ended = true;
         partition_pipeline.end();
+        if constexpr (IsOrdered) {
+          sender.complete(UnorderedSeq);
+        }
+        sender.flush();
         if constexpr (IsSinkWithRes) {
-          this->send(res_collector, codes::Data, std::make_pair(pid, partition_pipeline.result()));
+          this->send(sender.res_collector, codes::Data, std::make_pair(pid, partition_pipeline.result()));
         } else if constexpr (IsSinkWithoutRes) {
-          this->send(res_collector, codes::Data, pid);
+          this->send(sender.res_collector, codes::Data, pid);
         }
-        this->send(res_collector, codes::Termination);
+        this->send(sender.res_collector, codes::Termination);
+      }
+
+      void terminate() {
+        if (!ended) {
+          finish();
+        }
+        sender.flush();
         this->deactivate();
       }
 
+      // one message sent to this executor is processed
+      inline void acknowledge() {
+        if (ack_every > 0 && ++num_unacked >= ack_every) {
+          this->send(sender.res_collector, codes::Ack, pid, num_unacked);
+          num_unacked = 0;
+        }
+      }
+
+      inline void process(DispatchType& e) {
+        if constexpr (IsOrdered) {
+          if (!ended) {
+            partition_pipeline.process(e.value);
+          }
+          sender.complete(e.seq);
+        } else if (!ended) {
+          partition_pipeline.process(e);
+        }
+        if (!ended && partition_pipeline.control().break_now) {
+          finish();
+        }
+      }
+
+      inline void process_batch(std::vector<DispatchType>& batch) {
+        for (auto& e : batch) {
+          process(e);
+        }
+        // do not hold the outputs of a batch for too long
+        sender.flush();
+      }
+
+      // process the chunks of `shuffle::WorkStealing` until none is left,
+      // chunks are left to the other executors once this executor ends
+      inline void process_work_queues() {
+        if (!ended) {
+          work_queues->work(pid, [&](std::vector<DispatchType>& chunk) {
+            process_batch(chunk);
+            acknowledge();
+            return !ended;
+          });
+        }
+      }
+
+      std::shared_ptr<shuffle::details::WorkQueues<DispatchType>> work_queues;
+
       zaf::MessageHandlers behavior() override {
         return {
           codes::Downstream - [this](zaf::Actor res_collector) {
-            this->res_collector = res_collector;
+            this->sender.res_collector = res_collector;
           },
-          codes::Data - [this](QueueInputType& e) {
-            partition_pipeline.process(e);
-            if (partition_pipeline.control().break_now) {
-              terminate();
-            }
+          codes::Data - [this](DispatchType& e) {
+            process(e);
+            acknowledge();
+          },
+          codes::DataBatch - [this](std::vector<DispatchType>& batch) {
+            process_batch(batch);
+            acknowledge();
           },
           codes::Quota - [this](size_t w) {
             this->reply(codes::Quota, w);
           },
-          codes::DataWithQuota - [this](QueueInputType& e, size_t w) {
+          codes::DataWithQuota - [this](DispatchType& e, size_t w) {
             this->reply(codes::Quota, w);
-            partition_pipeline.process(e);
-            if (partition_pipeline.control().break_now) {
-              terminate();
-            }
+            process(e);
+            acknowledge();
+          },
+          codes::DataBatchWithQuota - [this](std::vector<DispatchType>& batch, size_t w) {
+            this->reply(codes::Quota, w);
+            process_batch(batch);
+            acknowledge();
+          },
+          codes::Steal - [this](std::shared_ptr<shuffle::details::WorkQueues<DispatchType>>& queues) {
+            work_queues = queues;
+            process_work_queues();
           },
           codes::Termination - [this]() {
+            if (work_queues) {
+              process_work_queues();
+            }
             this->terminate();
           }
         };
       }
     };
 
-    zaf::MessageHandlers receive_handlers{
-      codes::Data - [=](OutputType&& o) {
+    // The outputs of the input with sequence number `seq` are kept in `reorder_slots[seq % reorder_capacity]`
+    // until the outputs of all the inputs before `seq` are emitted.
+    struct ReorderSlot {
+      bool completed = false;
+      OutputBatchType outputs;
+    };
+    std::vector<ReorderSlot> reorder_slots;
+    // the sequence number of the next input to dispatch
+    size_t next_dispatch_seq = 0;
+    // the sequence number of the next input whose outputs are to emit
+    size_t next_emit_seq = 0;
+    OutputBatchType unordered_outputs;
+
+    inline ReorderSlot& reorder_slot(size_t seq) {
+      return reorder_slots[seq % reorder_slots.size()];
+    }
+
+    inline void emit(OutputBatchType& outputs) {
+      for (auto& o : outputs) {
+        if (this->control().break_now) {
+          break;
+        }
         this->Child::process(std::forward<OutputType>(o));
-      },
-      codes::Termination - [=]() {
-        this->num_termination++;
       }
-    };
+    }
+
+    inline void emit_completed() {
+      for (auto* slot = &reorder_slot(next_emit_seq); slot->completed; slot = &reorder_slot(++next_emit_seq)) {
+        emit(slot->outputs);
+        slot->outputs.clear();
+        slot->completed = false;
+      }
+    }
+
+    inline void reorder(OrderedOutputBatch& batch) {
+      size_t begin = 0;
+      for (auto& [seq, seq_end] : batch.ends) {
+        auto& outputs = seq == UnorderedSeq ? unordered_outputs : reorder_slot(seq).outputs;
+        std::move(batch.outputs.begin() + begin, batch.outputs.begin() + seq_end, std::back_inserter(outputs));
+        if (seq != UnorderedSeq) {
+          reorder_slot(seq).completed = true;
+        }
+        begin = seq_end;
+      }
+      emit_completed();
+    }
+
+    static zaf::MessageHandlers ctor_receive_handlers(Execution* self) {
+      if constexpr (IsOrdered) {
+        return {
+          codes::DataBatch - [self](OrderedOutputBatch& batch) {
+            self->reorder(batch);
+          },
+          codes::Ack - [self](size_t w, size_t n) {
+            self->shuffler.acknowledge(w, n);
+          },
+          codes::Termination - [self]() {
+            self->num_termination++;
+          }
+        };
+      } else {
+        return {
+          codes::Data - [self](OutputType&& o) {
+            self->Child::process(std::forward<OutputType>(o));
+          },
+          codes::DataBatch - [self](OutputBatchType& batch) {
+            self->emit(batch);
+          },
+          codes::Ack - [self](size_t w, size_t n) {
+            self->shuffler.acknowledge(w, n);
+          },
+          codes::Termination - [self]() {
+            self->num_termination++;
+          }
+        };
+      }
+    }
+
+    zaf::MessageHandlers receive_handlers = ctor_receive_handlers(this);
 
     inline void receive_results(bool non_blocking) {
       for (bool succ = true; succ && num_termination < args.parallelism;) {
@@ -201,29 +560,345 @@ struct Parallel {
     }
 
     inline void process(InputType e) {
-      shuffler.dispatch(std::forward<InputType>(e));
-      receive_results(true);
-      if (num_termination == args.parallelism) {
-        this->control().break_now = true;
+      if (shuffler.is_full()) {
+        // too many messages are not yet processed by the executors, help to drain their outputs meanwhile
+        while (shuffler.is_full() && num_termination < args.parallelism) {
+          shuffler.receive(receive_handlers, false);
+        }
+      }
+      if constexpr (IsOrdered) {
+        if (next_dispatch_seq - next_emit_seq >= reorder_slots.size()) {
+          // the reorder buffer is full, wait for the earliest inputs to complete
+          shuffler.flush_pending();
+          while (next_dispatch_seq - next_emit_seq >= reorder_slots.size() &&
+                 num_termination < args.parallelism) {
+            shuffler.receive(receive_handlers, false);
+          }
+        }
+        shuffler.dispatch(DispatchType{next_dispatch_seq++, std::forward<InputType>(e)});
+      } else {
+        shuffler.dispatch(std::forward<InputType>(e));
+      }
+      // with batching, results can only arrive after a batch is sent
+      if (--num_to_next_receive == 0) {
+        num_to_next_receive = args.batch_size;
+        receive_results(true);
+        if (num_termination == args.parallelism) {
+          this->control().break_now = true;
+        }
       }
     }
 
     inline void end() {
       shuffler.terminate();
       receive_results(false);
+      if constexpr (IsOrdered) {
+        // the inputs not completed yet were taken by the executors that ended by themselves, and have no output
+        for (; next_emit_seq < next_dispatch_seq; next_emit_seq++) {
+          auto& slot = reorder_slot(next_emit_seq);
+          emit(slot.outputs);
+          slot.outputs.clear();
+          slot.completed = false;
+        }
+        emit(unordered_outputs);
+        unordered_outputs.clear();
+      }
       shuffler.clear();
       Child::end();
     }
   };
 
+  using OutputQueueType = SPSCQueue<traits::remove_cvr_t<OutputType>>;
+
+  // The executor that runs on a worker thread and sends the outputs by an SPSC channel
+  struct ThreadExecutor {
+    ThreadExecutor(Args& args, size_t pid, size_t capacity):
+      pid(pid),
+      outputs(capacity),
+      partition_pipeline(ctor_partition_pipeline(args, pid, outputs)) {
+    }
+
+    template<typename U>
+    inline static void push(OutputQueueType& outputs, U&& o) {
+      while (!outputs.try_push(std::forward<U>(o))) {
+        std::this_thread::yield();
+      }
+    }
+
+    static auto ctor_partition_pipeline(Args& args, size_t pid,
+      [[maybe_unused]] OutputQueueType& outputs) {
+      if constexpr (IsPipeOperator) {
+        return args.pipeline_builder(pid, place_holder<QueueInputType&>())
+          | foreach([&outputs](OutputType o) {
+              push(outputs, std::forward<OutputType>(o));
+            });
+      } else {
+        return args.pipeline_builder(pid, place_holder<QueueInputType&>());
+      }
+    }
+
+    // end the partition pipeline and send its result, if any
+    void finish() {
+      partition_pipeline.end();
+      if constexpr (IsSinkWithRes) {
+        push(outputs, std::make_pair(pid, partition_pipeline.result()));
+      } else if constexpr (IsSinkWithoutRes) {
+        push(outputs, pid);
+      }
+      finished.store(true, std::memory_order_release);
+    }
+
+    using PartitionPipelineType = decltype(ctor_partition_pipeline(
+      std::declval<Args&>(), 0, std::declval<OutputQueueType&>()));
+
+    size_t pid;
+    OutputQueueType outputs;
+    PartitionPipelineType partition_pipeline;
+    // set by the executor when it will neither take inputs nor produce outputs
+    std::atomic<bool> finished{false};
+  };
+
+  // Pass the outputs of the executors to `process` until the child breaks, and drop the rest.
+  // Return true if all the executors are finished and all their outputs are consumed.
+  template<typename Executors, typename Ctrl, typename Process>
+  inline static bool drain_outputs(Executors& executors, Ctrl& ctrl, Process&& process) {
+    bool all_finished = true;
+    for (auto& e : executors) {
+      // check `finished` before `outputs` so no output is missed
+      bool finished = e->finished.load(std::memory_order_acquire);
+      for (auto o = e->outputs.front(); o; o = e->outputs.front()) {
+        if (!ctrl.break_now) {
+          process(*o);
+        }
+        e->outputs.pop();
+      }
+      all_finished &= finished;
+    }
+    return all_finished;
+  }
+
+  template<typename Child>
+  struct ChannelExecution : public Child {
+    template<typename ... X>
+    ChannelExecution(const Args& args, X&& ... x):
+      Child(std::forward<X>(x)...),
+      args(args) {
+    }
+
+    struct ChannelExecutor : public ThreadExecutor {
+      ChannelExecutor(Args& args, size_t pid):
+        ThreadExecutor(args, pid, args.channel_capacity),
+        inputs(args.channel_capacity) {
+      }
+
+      void run() {
+        auto& partition_pipeline = this->partition_pipeline;
+        while (!partition_pipeline.control().break_now) {
+          if (auto e = inputs.front()) {
+            partition_pipeline.process(*e);
+            inputs.pop();
+          } else if (closed.load(std::memory_order_acquire)) {
+            // inputs pushed before `closed` are visible now
+            if (inputs.empty()) {
+              break;
+            }
+          } else {
+            std::this_thread::yield();
+          }
+        }
+        this->finish();
+      }
+
+      SPSCQueue<QueueInputType> inputs;
+      // set by the operator when there is no more input
+      std::atomic<bool> closed{false};
+    };
+
+    ~ChannelExecution() {
+      // in case the execution is dropped before `end`
+      for (auto& e : executors) {
+        e->closed.store(true, std::memory_order_release);
+      }
+      lease.release();
+    }
+
+    inline void start() {
+      executors.reserve(args.parallelism);
+      for (size_t i = 0; i < args.parallelism; i++) {
+        executors.emplace_back(new ChannelExecutor(args, i));
+      }
+      lease = args.get_executor_pool().lease(args.parallelism);
+      for (size_t i = 0; i < args.parallelism; i++) {
+        lease.run(i, [e = executors[i].get()]() { e->run(); });
+      }
+      Child::start();
+    }
+
+    Args args;
+    auto_val(shuffler, args.shuffle_strategy.template create<QueueInputType>());
+    std::vector<std::unique_ptr<ChannelExecutor>> executors;
+    ExecutorPool::Lease lease;
+    size_t next_executor = 0;
+
+    // return true if all the executors are finished and all their outputs are consumed
+    inline bool receive_results() {
+      return drain_outputs(executors, this->control(), [this](auto& o) {
+        this->Child::process(std::forward<OutputType>(o));
+      });
+    }
+
+    inline void process(InputType e) {
+      constexpr bool select_by_shuffler = parallel_utils::has_select<decltype(shuffler), QueueInputType>::value;
+      if constexpr (select_by_shuffler) {
+        auto& executor = *executors[shuffler.select(e, executors.size())];
+        while (!executor.finished.load(std::memory_order_acquire) &&
+               !executor.inputs.try_push(std::forward<InputType>(e))) {
+          if (receive_results()) {
+            break;
+          }
+          std::this_thread::yield();
+        }
+      } else {
+        for (size_t num_tries = 1;; num_tries++) {
+          auto& executor = *executors[next_executor];
+          next_executor = next_executor + 1 == executors.size() ? 0 : next_executor + 1;
+          if (!executor.finished.load(std::memory_order_acquire) &&
+              executor.inputs.try_push(std::forward<InputType>(e))) {
+            break;
+          }
+          if (num_tries % executors.size() == 0) {
+            // none of the executors takes the input now
+            if (receive_results()) {
+              break;
+            }
+            std::this_thread::yield();
+          }
+        }
+      }
+      if (receive_results()) {
+        this->control().break_now = true;
+      }
+    }
+
+    inline void end() {
+      for (auto& e : executors) {
+        e->closed.store(true, std::memory_order_release);
+      }
+      while (!receive_results()) {
+        std::this_thread::yield();
+      }
+      // the workers go back to the pool before the child ends, so that they can be reused downstream
+      lease.release();
+      executors.clear();
+      Child::end();
+    }
+  };
+
+  // The parent is a source that is split into one sub-source per executor, and no element is dispatched.
+  // Only the default shuffle strategy, which does not care where an element goes, allows splitting.
+  constexpr static bool IsSplit = Splittable && parallel_utils::has_split<Parent>::value &&
+    std::is_same<traits::remove_cvr_t<decltype(std::declval<Args&>().shuffle_strategy)>, shuffle::OnDemandAssign>::value &&
+    !Args::use_channels && !IsOrdered;
+
+  template<typename Child>
+  struct SplitExecution : public Child {
+    using TriggersType = Triggers<Run<>>;
+    using SourceType = typename decltype(std::declval<Parent&>().split(size_t(0)))::value_type;
+
+    template<typename ... X>
+    SplitExecution(const Parent& parent, const Args& args, X&& ... x):
+      Child(std::forward<X>(x)...),
+      parent(parent),
+      args(args) {
+    }
+
+    struct SplitExecutor : public ThreadExecutor {
+      SplitExecutor(Args& args, size_t pid, SourceType&& source):
+        ThreadExecutor(args, pid, args.channel_capacity > 0 ? args.channel_capacity : 4096),
+        source(std::move(source)) {
+      }
+
+      void run(const std::atomic<bool>& stopped) {
+        auto& partition_pipeline = this->partition_pipeline;
+        source
+          | take_while([&](auto&&) {
+              return !partition_pipeline.control().break_now && !stopped.load(std::memory_order_relaxed);
+            })
+          | foreach([&](auto&& e) {
+              if constexpr (std::is_same<decltype(e), QueueInputType&>::value) {
+                partition_pipeline.process(e);
+              } else {
+                QueueInputType copy = e;
+                partition_pipeline.process(copy);
+              }
+            });
+        this->finish();
+      }
+
+      SourceType source;
+    };
+
+    Parent parent;
+    Args args;
+    // set by the operator when the child breaks
+    std::atomic<bool> stopped{false};
+
+    inline void run() {
+      if (args.actor_group) {
+        // dispatch the elements to the actors of the given group instead
+        Parallel<Parent, Args, false>{parent, args}
+          | take_while([this](auto&&) { return !this->control().break_now; })
+          | foreach([this](auto&& o) { this->Child::process(std::forward<OutputType>(o)); });
+        return;
+      }
+      auto sources = parent.split(args.parallelism);
+      std::vector<std::unique_ptr<SplitExecutor>> executors;
+      executors.reserve(args.parallelism);
+      for (size_t i = 0; i < args.parallelism; i++) {
+        executors.emplace_back(new SplitExecutor(args, i, std::move(sources[i])));
+      }
+      auto lease = args.get_executor_pool().lease(args.parallelism);
+      for (size_t i = 0; i < args.parallelism; i++) {
+        lease.run(i, [this, e = executors[i].get()]() { e->run(stopped); });
+      }
+      while (!drain_outputs(executors, this->control(), [this](auto& o) {
+          this->Child::process(std::forward<OutputType>(o));
+        })) {
+        if (this->control().break_now) {
+          stopped.store(true, std::memory_order_relaxed);
+        }
+        std::this_thread::yield();
+      }
+      lease.release();
+    }
+  };
+
   template<ExecutionType ET, typename Child, typename ... X>
   inline decltype(auto) wrap(X&& ... x) {
     using Ctrl = traits::operator_control_t<Child>;
     static_assert(!Ctrl::is_reversed,
       "Parallel operator does not support reversion. Use `with_buffer()` for the nearest `reverse`");
-    return parent.template wrap<ET, Execution<Child>, Args&, X...>(
-      args, std::forward<X>(x)...
-    );
+    if constexpr (IsSplit) {
+      if constexpr (ET == Construct) {
+        return Child::template construct<ExecutionType::Execute, SplitExecution<Child>>(
+          parent, args, std::forward<X>(x)...
+        );
+      } else if constexpr (ET == Execute) {
+        return Child::template execute<SplitExecution<Child>>(
+          parent, args, std::forward<X>(x)...
+        );
+      } else {
+        return SplitExecution<Child>(parent, args, std::forward<X>(x)...);
+      }
+    } else if constexpr (Args::use_channels) {
+      return parent.template wrap<ET, ChannelExecution<Child>, Args&, X...>(
+        args, std::forward<X>(x)...
+      );
+    } else {
+      return parent.template wrap<ET, Execution<Child>, Args&, X...>(
+        args, std::forward<X>(x)...
+      );
+    }
   }
 };
 
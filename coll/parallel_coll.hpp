@@ -2,6 +2,7 @@
 
 #if ENABLE_PARALLEL
 
+#include "executor_pool.hpp"
 #include "parallel.hpp"
 #include "parallel_partition.hpp"
 #include "shuffle_strategy.hpp"
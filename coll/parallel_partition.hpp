@@ -1,13 +1,23 @@
 #pragma once
 #if ENABLE_PARALLEL
 
+#include <optional>
+#include <vector>
+
+#include "flat_hash_map.hpp"
+#include "map.hpp"
 #include "parallel.hpp"
 #include "partition.hpp"
 
 namespace coll {
+namespace parallel_partition_utils {
+// The default number of slots of the table of pending (key, partial) pairs of `combine`
+constexpr size_t DefaultCombineCapacity = 1024;
+} // namespace parallel_partition_utils
+
 struct ParallelPartitionArgsTag {};
 
-template<typename PipeBuilder, typename KeyBy = Identity::type>
+template<typename PipeBuilder, typename KeyBy = Identity::type, typename Combiner = NullArg>
 struct ParallelPartitionArgs {
   using TagType = ParallelPartitionArgsTag;
 
@@ -15,20 +25,73 @@ struct ParallelPartitionArgs {
   PipeBuilder pipe_builder;
   KeyBy keyby = Identity::value;
   zaf::ActorGroup* actor_group = nullptr;
+  ExecutorPool* executor_pool = nullptr;
+  size_t batch_size = 1;
+  size_t in_flight_limit = 0;
+  Combiner combiner = {};
+  size_t combine_capacity = parallel_partition_utils::DefaultCombineCapacity;
+
+  constexpr static bool is_combined = !std::is_same<Combiner, NullArg>::value;
 
   auto& execute_by(zaf::ActorGroup& group) {
     actor_group = &group;
     return *this;
   }
 
+  auto& execute_by(ExecutorPool& pool) {
+    executor_pool = &pool;
+    return *this;
+  }
+
+  auto& batch(size_t size) {
+    batch_size = std::max<size_t>(size, 1);
+    return *this;
+  }
+
+  auto& max_in_flight(size_t limit) {
+    in_flight_limit = limit;
+    return *this;
+  }
+
   template<typename AnotherKeyBy>
-  inline ParallelPartitionArgs<PipeBuilder, AnotherKeyBy>
+  inline ParallelPartitionArgs<PipeBuilder, AnotherKeyBy, Combiner>
   key_by(AnotherKeyBy&& another_keyby) {
     return {
       parallelism,
       std::forward<PipeBuilder>(pipe_builder),
       std::forward<AnotherKeyBy>(another_keyby),
-      actor_group
+      actor_group,
+      executor_pool,
+      batch_size,
+      in_flight_limit,
+      std::forward<Combiner>(combiner),
+      combine_capacity
+    };
+  }
+
+  /**
+   * Pre-aggregate the elements of the same key before they are shuffled.
+   * `another_combiner(partial, elem)` merges `elem` into `partial`, which is the first element of the key.
+   * The producer keeps up to `capacity` pending (key, partial) pairs, and a pair is sent to its
+   * partition when it is evicted by another key or when the input ends.
+   *
+   * The partition pipeline receives partials instead of the original elements, e.g.,
+   * `combine([](auto& s, auto e) { s += e; })` for a `sum()` pipeline.
+   **/
+  template<typename AnotherCombiner>
+  inline ParallelPartitionArgs<PipeBuilder, KeyBy, AnotherCombiner>
+  combine(AnotherCombiner&& another_combiner,
+    size_t capacity = parallel_partition_utils::DefaultCombineCapacity) {
+    return {
+      parallelism,
+      std::forward<PipeBuilder>(pipe_builder),
+      std::forward<KeyBy>(keyby),
+      actor_group,
+      executor_pool,
+      batch_size,
+      in_flight_limit,
+      std::forward<AnotherCombiner>(another_combiner),
+      std::max<size_t>(capacity, 1)
     };
   }
 };
@@ -39,18 +102,111 @@ parallel_partition(size_t parallelism, PipeBuilder builder) {
   return {parallelism, builder};
 }
 
+/**
+ * The producer side of `parallel_partition(...).combine(...)`.
+ * Outputs (key, partial) pairs, each of which combines a run of elements of the key.
+ * The pending pairs are kept in a direct-mapped table, so a pair is evicted by a colliding key.
+ **/
+template<typename Parent, typename Args>
+struct PartitionCombine {
+  using InputType = typename traits::remove_cvr_t<Parent>::OutputType;
+  using KeyType = traits::remove_cvr_t<typename traits::invocation<decltype(Args::keyby), InputType>::result_t>;
+  using OutputType = std::pair<KeyType, traits::remove_cvr_t<InputType>>;
+
+  Parent parent;
+  Args args;
+
+  template<typename Child>
+  struct Execution : public Child {
+    template<typename ... X>
+    Execution(const Args& args, X&& ... x):
+      Child(std::forward<X>(x)...),
+      args(args),
+      slots(num_slots(args.combine_capacity)),
+      mask(slots.size() - 1) {
+    }
+
+    // round up to a power of 2 so that a slot is selected by masking the hash
+    static inline size_t num_slots(size_t capacity) {
+      size_t n = 1;
+      while (n < capacity) {
+        n *= 2;
+      }
+      return n;
+    }
+
+    Args args;
+    std::vector<std::optional<OutputType>> slots;
+    size_t mask;
+    std::hash<KeyType> hasher{};
+
+    inline void process(InputType e) {
+      auto&& key = args.keyby(e);
+      auto& slot = slots[flat_hash_utils::mix(hasher(key)) & mask];
+      if (slot) {
+        if (slot->first == key) {
+          args.combiner(slot->second, std::forward<InputType>(e));
+          return;
+        }
+        Child::process(std::move(*slot));
+      }
+      slot.emplace(key, std::forward<InputType>(e));
+    }
+
+    inline void end() {
+      for (auto& slot : slots) {
+        if (slot) {
+          Child::process(std::move(*slot));
+          slot.reset();
+        }
+      }
+      Child::end();
+    }
+  };
+
+  template<ExecutionType ET, typename Child, typename ... X>
+  inline decltype(auto) wrap(X&& ... x) {
+    using Ctrl = traits::operator_control_t<Child>;
+    static_assert(!Ctrl::is_reversed,
+      "ParallelPartition operator does not support reversion. Use `with_buffer()` for the nearest `reverse`");
+    return parent.template wrap<ET, Execution<Child>, Args&, X...>(
+      args, std::forward<X>(x)...
+    );
+  }
+};
+
 template<typename Parent, typename Args,
   typename P = traits::remove_cvr_t<Parent>,
   typename A = traits::remove_cvr_t<Args>,
   std::enable_if_t<std::is_same<typename A::TagType, ParallelPartitionArgsTag>::value>* = nullptr,
   std::enable_if_t<traits::is_pipe_operator<P>::value>* = nullptr>
 inline auto operator | (Parent&& parent, Args&& args) {
-  return parent
-    | parallel(args.parallelism, [=](size_t, auto in) {
+  auto setup = [&](auto&& parallel_args) {
+    parallel_args.actor_group = args.actor_group;
+    parallel_args.executor_pool = args.executor_pool;
+    parallel_args.batch(args.batch_size);
+    parallel_args.max_in_flight(args.in_flight_limit);
+    return std::move(parallel_args);
+  };
+  if constexpr (A::is_combined) {
+    // partials are routed by the key they are combined by, which may differ from the key of the partials
+    auto parallel_args = parallel(args.parallelism, [=](size_t, auto in) {
+        return in
+          | partition([=](auto& key, auto pin) {
+              return args.pipe_builder(key, pin | map(anony_ar(_.second)));
+            })
+            .by(anony_ar(_.first));
+      })
+      .shuffle_by(shuffle::Partition(anony_ar(_.first)));
+    return PartitionCombine<P, A>{std::forward<Parent>(parent), std::forward<Args>(args)}
+      | setup(std::move(parallel_args));
+  } else {
+    auto parallel_args = parallel(args.parallelism, [=](size_t, auto in) {
         return in | partition(args.pipe_builder).by(args.keyby);
       })
-      .shuffle_by(shuffle::Partition(args.keyby))
-      .execute_by(*args.actor_group);
+      .shuffle_by(shuffle::Partition(args.keyby));
+    return std::forward<Parent>(parent) | setup(std::move(parallel_args));
+  }
 }
 } // namespace coll
 #endif
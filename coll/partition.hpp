@@ -1,7 +1,10 @@
 #pragma once
 
+#include <list>
+
 #include "base.hpp"
 #include "partition_args.hpp"
+#include "spill.hpp"
 
 #include "foreach.hpp"
 
@@ -64,42 +67,142 @@ struct Partition {
       }
     }
 
+    using ElemType = traits::remove_cvr_t<InputType>;
+    using Buckets = std::conditional_t<Args::is_external, spill_utils::SpillBuckets<ElemType>, NullArg>;
+
     Args args;
     Child* child = this;
     auto_val(partition_map, construct_partition_map(args));
+    // the elements of the keys not in memory and the estimated bytes of the partitions in memory,
+    // if `memory_limit` is given
+    Buckets buckets = make_buckets(args, 0);
+    size_t partition_bytes = 0;
+    // the hashes of the keys whose elements are spilled to the buckets being written
+    std::conditional_t<Args::is_external, FlatHashSet<size_t>, NullArg> spilled_hashes;
+    // the keys from the least to the most recently used partitions if `max_partitions` is given
+    std::list<KeyType> lru_keys;
+    FlatHashMap<KeyType, typename std::list<KeyType>::iterator> lru_index;
+
+    static Buckets make_buckets([[maybe_unused]] const Args& args, [[maybe_unused]] size_t level) {
+      if constexpr (Args::is_external) {
+        return Buckets(args.spill_directory, level);
+      } else {
+        return {};
+      }
+    }
 
     inline void process(InputType e) {
+      dispatch(std::forward<InputType>(e), buckets);
+    }
+
+    inline void dispatch(InputType e, Buckets& spilled) {
       auto&& key = args.keyby(e);
       auto iter = partition_map.find(key);
       if (iter == partition_map.end()) {
+        if constexpr (Args::is_external) {
+          // once the elements of a key are spilled, its following elements are spilled as well,
+          // such that they are processed in order by a single partition
+          auto hash = std::hash<KeyType>{}(key);
+          if ((partition_bytes >= args.memory_budget && spilled.can_spill()) || spilled_hashes.contains(hash)) {
+            spilled_hashes.insert(hash);
+            spilled.write(hash, e);
+            return;
+          }
+        }
+        if (args.max_num_partitions != 0 && partition_map.size() >= args.max_num_partitions) {
+          evict();
+        }
         const auto& const_key = key;
         iter = partition_map.emplace(key, construct_partition_pipeline(args, const_key, child)).first;
+        if (args.max_num_partitions != 0) {
+          touch(key);
+        }
         // end when created
         if (unlikely(iter->second.control().break_now)) {
           end_partition(key, iter->second);
+          partition_bytes += estimated_size(iter);
           return;
         }
+        partition_bytes += estimated_size(iter);
+      } else if (args.max_num_partitions != 0) {
+        touch(key);
       }
       auto& pipe = iter->second;
       // if the partition has ended but there are still new elements coming into this partition
       if (likely(!pipe.control().break_now)) {
+        partition_bytes -= estimated_size(iter);
         pipe.process(std::forward<InputType>(e));
         if (unlikely(pipe.control().break_now)) {
           end_partition(key, pipe);
         }
+        partition_bytes += estimated_size(iter);
+      }
+    }
+
+    // the estimated bytes of the partition of `iter` if `memory_limit` is given, which are counted
+    // when it is created or has processed an element, and uncounted when it is removed
+    template<typename I>
+    inline size_t estimated_size([[maybe_unused]] const I& iter) {
+      if constexpr (Args::is_external) {
+        return args.size_of(iter->first, iter->second);
+      } else {
+        return 0;
       }
     }
 
+    inline void touch(const KeyType& key) {
+      auto iter = lru_index.find(key);
+      if (iter == lru_index.end()) {
+        lru_index.emplace(key, lru_keys.insert(lru_keys.end(), key));
+      } else {
+        lru_keys.splice(lru_keys.end(), lru_keys, iter->second);
+      }
+    }
+
+    // end and remove the least recently used partition
+    inline void evict() {
+      auto& key = lru_keys.front();
+      auto iter = partition_map.find(key);
+      partition_bytes -= estimated_size(iter);
+      if (!iter->second.control().break_now) {
+        end_partition(iter->first, iter->second);
+      }
+      partition_map.erase(iter);
+      lru_index.erase(key);
+      lru_keys.pop_front();
+    }
+
     // end when parent ends;
     // does not know how many number of keys there will be,
     // so do not know when *all* the partitions end.
     inline void end() {
+      end_partitions(buckets);
+      Child::end();
+    }
+
+    // end the partitions in memory and then partition the spilled buckets one by one
+    void end_partitions([[maybe_unused]] Buckets& spilled) {
       for (auto& i : partition_map) {
         if (!i.second.control().break_now) {
           end_partition(i.first, i.second);
         }
       }
-      Child::end();
+      if constexpr (Args::is_external) {
+        partition_map.clear();
+        partition_bytes = 0;
+        lru_keys.clear();
+        lru_index.clear();
+        for (auto& file : spilled.finish()) {
+          auto next = make_buckets(args, spilled.next_level());
+          spilled_hashes.clear();
+          auto reader = file.reader();
+          ElemType e;
+          while (reader.next(e)) {
+            dispatch(static_cast<InputType>(e), next);
+          }
+          end_partitions(next);
+        }
+      }
     }
 
     // just do not want to think about what K and P are
@@ -1,6 +1,10 @@
 #pragma once
 
+#include <string>
+
+#include "flat_hash_map.hpp"
 #include "place_holder.hpp"
+#include "spill.hpp"
 #include "utils.hpp"
 
 namespace coll {
@@ -9,24 +13,94 @@ struct PartitionArgsTag {};
 template<
   typename PipelineBuilder,
   typename PartitionMapBuilder,
-  typename KeyBy = Identity::type
+  typename KeyBy = Identity::type,
+  bool External = false,
+  typename SizeOf = spill_utils::EstimatedSize
 > struct PartitionArgs {
   using TagType = PartitionArgsTag;
 
   PipelineBuilder pipeline_builder;
   PartitionMapBuilder partition_map_builder;
   KeyBy keyby = Identity::value;
+  size_t memory_budget = 0;
+  std::string spill_directory{};
+  size_t max_num_partitions = 0;
+  SizeOf size_of{};
 
   template<typename AnotherKeyBy>
-  inline PartitionArgs<PipelineBuilder, PartitionMapBuilder, AnotherKeyBy>
+  inline PartitionArgs<PipelineBuilder, PartitionMapBuilder, AnotherKeyBy, External, SizeOf>
   by(AnotherKeyBy&& another_keyby) {
     return {
       std::forward<PipelineBuilder>(pipeline_builder),
       std::forward<PartitionMapBuilder>(partition_map_builder),
-      std::forward<AnotherKeyBy>(another_keyby)
+      std::forward<AnotherKeyBy>(another_keyby),
+      memory_budget,
+      spill_directory,
+      max_num_partitions,
+      std::forward<SizeOf>(size_of)
+    };
+  }
+
+  // `another_map_builder(Type<K>{}, Type<V>{})` returns the map, e.g., `with_map(arena.maps<NodeHashMap>())`.
+  template<typename AnotherMapBuilder>
+  inline PartitionArgs<PipelineBuilder, AnotherMapBuilder, KeyBy, External, SizeOf>
+  with_map(AnotherMapBuilder&& another_map_builder) {
+    return {
+      std::forward<PipelineBuilder>(pipeline_builder),
+      std::forward<AnotherMapBuilder>(another_map_builder),
+      std::forward<KeyBy>(keyby),
+      memory_budget,
+      spill_directory,
+      max_num_partitions,
+      std::forward<SizeOf>(size_of)
     };
   }
 
+  /**
+   * Keep at most about `bytes` of partitions in memory, where `size_of(key, pipeline)` estimates the bytes
+   * of a partition after each of its elements. By default, it counts the memory allocated by a string or container
+   * key and the size of the pipeline type, but not the memory allocated by the pipeline, e.g., by `to<std::vector>()`,
+   * which needs a custom `size_of`. The memory is only bounded as well as the estimation.
+   * Once the limit is reached, the elements of new keys are written to on-disk buckets through `Serializer`,
+   * which are partitioned when the input ends, after the partitions in memory end.
+   **/
+  inline PartitionArgs<PipelineBuilder, PartitionMapBuilder, KeyBy, true, SizeOf>
+  memory_limit(size_t bytes) {
+    return memory_limit(bytes, std::forward<SizeOf>(size_of));
+  }
+
+  template<typename AnotherSizeOf>
+  inline PartitionArgs<PipelineBuilder, PartitionMapBuilder, KeyBy, true, AnotherSizeOf>
+  memory_limit(size_t bytes, AnotherSizeOf another_size_of) {
+    return {
+      std::forward<PipelineBuilder>(pipeline_builder),
+      std::forward<PartitionMapBuilder>(partition_map_builder),
+      std::forward<KeyBy>(keyby),
+      std::max<size_t>(bytes, 1),
+      spill_directory,
+      max_num_partitions,
+      std::forward<AnotherSizeOf>(another_size_of)
+    };
+  }
+
+  // The directory of the temporary files, which is `std::filesystem::temp_directory_path()` by default.
+  inline PartitionArgs& spill_dir(const std::string& dir) {
+    spill_directory = dir;
+    return *this;
+  }
+
+  /**
+   * Keep at most `n` partitions. Before a partition of a new key is created, the least recently used
+   * partition is ended, which outputs its result immediately, and removed.
+   * A later element of an evicted key starts a new partition of the key, e.g., a new session.
+   **/
+  inline PartitionArgs& max_partitions(size_t n) {
+    max_num_partitions = n;
+    return *this;
+  }
+
+  constexpr static bool is_external = External;
+
   template<typename Input>
   using KeyType = traits::remove_cvr_t<
     typename traits::invocation<KeyBy, Input>::result_t
@@ -63,8 +137,9 @@ inline auto partition(PipelineBuilder&& pipeline_builder) {
   };
 }
 
+// Use `partition<std::unordered_map>(builder)` for the std container
 template<typename PipelineBuilder>
 inline auto partition(PipelineBuilder&& builder) {
-  return partition<std::unordered_map>(std::forward<PipelineBuilder>(builder));
+  return partition<NodeHashMap>(std::forward<PipelineBuilder>(builder));
 }
 } // namespace coll
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <algorithm>
+#include <vector>
+
 #include "base.hpp"
 #include "triggers.hpp"
 
@@ -50,6 +53,31 @@ struct Range {
     }
   };
 
+  // Split into `n` consecutive sub-ranges with (almost) the same number of elements.
+  // Used by `parallel` to let each executor iterate a sub-range by itself.
+  template<typename E = I, std::enable_if_t<std::is_integral<E>::value>* = nullptr>
+  std::vector<Range<I, S>> split(size_t n) const {
+    size_t size = 0, stride = 1;
+    if constexpr (std::is_same_v<S, NullArg>) {
+      size = left < right ? right - left : 0;
+    } else {
+      stride = step;
+      size = left < right ? (right - left + stride - 1) / stride : 0;
+    }
+    std::vector<Range<I, S>> ranges;
+    ranges.reserve(n);
+    for (size_t i = 0, begin = 0; i < n; i++) {
+      size_t end = begin + size / n + (i < size % n);
+      ranges.push_back({
+        I(left + begin * stride),
+        end == size ? right : I(left + end * stride),
+        step
+      });
+      begin = end;
+    }
+    return ranges;
+  }
+
   template<ExecutionType ET, typename Child, typename ... X>
   inline decltype(auto) wrap(X&& ... x) {
     if constexpr (ET == Construct) {
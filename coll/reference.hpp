@@ -142,8 +142,8 @@ template<typename T>
 struct hash<optional<T&>> {
   inline size_t operator()(const optional<T&>& r) const {
     return bool(r)
-      ? 0
-      : std::hash<T>{}(*r);
+      ? std::hash<std::remove_cv_t<T>>{}(*r)
+      : 0;
   }
 };
 } // namespace std
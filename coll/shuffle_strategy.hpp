@@ -1,20 +1,62 @@
 #pragma once
 #if ENABLE_PARALLEL
 
+#include <algorithm>
+#include <atomic>
 #include <deque>
+#include <memory>
+#include <mutex>
 #include <vector>
 
 #include "message_codes.hpp"
 
 namespace coll {
 namespace shuffle {
+// An element tagged with its sequence number, dispatched by `parallel(...).ordered()`
+template<typename T>
+struct Sequenced {
+  size_t seq;
+  T value;
+};
+
 namespace details {
-template<typename I>
-class RandomAssign {
+template<typename T>
+struct unsequenced { using type = T; };
+
+template<typename T>
+struct unsequenced<Sequenced<T>> { using type = T; };
+
+template<typename T>
+inline T& unsequence(T& elem) { return elem; }
+
+template<typename T>
+inline T& unsequence(Sequenced<T>& elem) { return elem.value; }
+
+/**
+ * Sends elements directly from the forwarder to the executors.
+ * `Strat::select(elem, num_executors)` decides which executor an element goes to.
+ *
+ * If `batch_size` > 1, the elements are packed into one buffer per executor and
+ * a whole buffer is sent by a single `codes::DataBatch` message once it is full.
+ *
+ * If `max_in_flight` > 0, it is full once any executor has `max_in_flight` messages not acknowledged.
+ **/
+template<typename I, typename Strat>
+class DirectAssign {
 public:
-  void initialize(zaf::ActorGroup& group, std::vector<zaf::Actor>& executors) {
+  void initialize(zaf::ActorGroup& group, std::vector<zaf::Actor>& executors, size_t batch_size,
+    size_t max_in_flight) {
     forwarder = group.create_scoped_actor<zaf::ActorBehaviorX>();
     this->executors = executors;
+    this->batch_size = batch_size;
+    this->max_in_flight = max_in_flight;
+    in_flight.assign(executors.size(), 0);
+    if (batch_size > 1) {
+      batches.resize(executors.size());
+      for (auto& b : batches) {
+        b.reserve(batch_size);
+      }
+    }
     for (auto& e : executors) {
       forwarder->send(e, codes::Downstream, forwarder->get_self_actor());
     }
@@ -22,14 +64,33 @@ public:
 
   template<typename U>
   inline void dispatch(U&& elem) {
-    forwarder->send(executors[rand() % executors.size()], codes::Data, std::forward<U>(elem));
+    auto w = static_cast<Strat*>(this)->select(elem, executors.size());
+    if (batch_size <= 1) {
+      forwarder->send(executors[w], codes::Data, std::forward<U>(elem));
+      sent(w);
+    } else {
+      batches[w].emplace_back(std::forward<U>(elem));
+      if (batches[w].size() >= batch_size) {
+        flush(w);
+      }
+    }
   }
 
   inline void clear() {
     forwarder = nullptr;
   }
 
+  // send out all the elements buffered for batching
+  void flush_pending() {
+    for (size_t w = 0; w < batches.size(); w++) {
+      if (!batches[w].empty()) {
+        flush(w);
+      }
+    }
+  }
+
   void terminate() {
+    flush_pending();
     for (auto& e : executors) {
       forwarder->send(e, codes::Termination);
     }
@@ -39,69 +100,115 @@ public:
     return forwarder->receive_once(handlers, non_blocking);
   }
 
-private:
-  std::vector<zaf::Actor> executors;
-  zaf::ScopedActor<zaf::ActorBehaviorX> forwarder;
-};
+  inline bool is_full() const {
+    return num_full > 0;
+  }
 
-template<typename I, typename KeyBy>
-class Partition {
-public:
-  using KeyType = traits::remove_cvr_t<typename traits::invocation<KeyBy, I>::result_t>;
+  // executor `w` has processed `n` messages
+  inline void acknowledge(size_t w, size_t n) {
+    bool was_full = in_flight[w] >= max_in_flight;
+    in_flight[w] -= n;
+    num_full -= was_full && in_flight[w] < max_in_flight;
+  }
 
-  Partition(const KeyBy& key_by):
-    key_by(key_by) {
+private:
+  inline void flush(size_t w) {
+    forwarder->send(executors[w], codes::DataBatch, std::move(batches[w]));
+    sent(w);
+    batches[w] = std::vector<I>{};
+    batches[w].reserve(batch_size);
   }
 
-  void initialize(zaf::ActorGroup& group, std::vector<zaf::Actor>& executors) {
-    forwarder = group.create_scoped_actor<zaf::ActorBehaviorX>();
-    this->executors = executors;
-    for (auto& e : executors) {
-      forwarder->send(e, codes::Downstream, forwarder->get_self_actor());
+  inline void sent(size_t w) {
+    if (max_in_flight > 0) {
+      num_full += ++in_flight[w] == max_in_flight;
     }
   }
 
+  std::vector<zaf::Actor> executors;
+  zaf::ScopedActor<zaf::ActorBehaviorX> forwarder;
+  size_t batch_size = 1;
+  std::vector<std::vector<I>> batches;
+  size_t max_in_flight = 0;
+  std::vector<size_t> in_flight;
+  // the number of executors with `max_in_flight` messages not acknowledged
+  size_t num_full = 0;
+};
+
+template<typename I>
+class RandomAssign : public DirectAssign<I, RandomAssign<I>> {
+public:
   template<typename U>
-  inline void dispatch(U&& elem) {
-    auto key_hash = hasher(key_by(elem));
-    forwarder->send(executors[key_hash % executors.size()], codes::Data, std::forward<U>(elem));
+  inline size_t select(U&, size_t num_executors) {
+    return rand() % num_executors;
   }
+};
 
-  inline void clear() {
-    forwarder = nullptr;
-  }
+template<typename I, typename KeyBy>
+class Partition : public DirectAssign<I, Partition<I, KeyBy>> {
+public:
+  using KeyType = traits::remove_cvr_t<typename traits::invocation<KeyBy, typename unsequenced<I>::type>::result_t>;
 
-  void terminate() {
-    for (auto& e : executors) {
-      forwarder->send(e, codes::Termination);
-    }
+  Partition(const KeyBy& key_by):
+    key_by(key_by) {
   }
 
-  inline bool receive(zaf::MessageHandlers& handlers, bool non_blocking) {
-    return forwarder->receive_once(handlers, non_blocking);
+  template<typename U>
+  inline size_t select(U& elem, size_t num_executors) {
+    return hasher(key_by(unsequence(elem))) % num_executors;
   }
 
 private:
-  std::vector<zaf::Actor> executors;
-  zaf::ScopedActor<zaf::ActorBehaviorX> forwarder;
   KeyBy key_by;
   std::hash<KeyType> hasher{};
 };
 
+/**
+ * Elements are forwarded to a `Dispatcher` actor, which hands them out to the executors that have quotas.
+ *
+ * If `batch_size` > 1, the forwarder packs elements into batches and the `Dispatcher` hands out
+ * a whole batch per quota.
+ *
+ * If `max_in_flight` > 0, it is full once `max_in_flight * num_executors` messages are not acknowledged,
+ * which also bounds the units buffered by the `Dispatcher`.
+ **/
 template<typename I>
 class OnDemandAssign {
 public:
-  inline void initialize(zaf::ActorGroup& group, std::vector<zaf::Actor>& executors) {
+  inline void initialize(zaf::ActorGroup& group, std::vector<zaf::Actor>& executors, size_t batch_size,
+    size_t max_in_flight) {
     forwarder = group.create_scoped_actor<zaf::ActorBehaviorX>();
-    dispatcher = group.spawn<Dispatcher>(executors, forwarder->get_self_actor());
+    this->batch_size = batch_size;
+    this->max_in_flight = max_in_flight * executors.size();
+    if (batch_size <= 1) {
+      dispatcher = group.spawn<Dispatcher<I>>(executors, forwarder->get_self_actor());
+    } else {
+      batch.reserve(batch_size);
+      dispatcher = group.spawn<Dispatcher<std::vector<I>>>(executors, forwarder->get_self_actor());
+    }
   }
 
   template<typename U>
   inline void dispatch(U&& elem) {
-    forwarder->send(dispatcher, codes::Data, std::forward<U>(elem));
+    if (batch_size <= 1) {
+      forwarder->send(dispatcher, codes::Data, std::forward<U>(elem));
+      in_flight++;
+    } else {
+      batch.emplace_back(std::forward<U>(elem));
+      if (batch.size() >= batch_size) {
+        flush();
+      }
+    }
+  }
+
+  inline void flush_pending() {
+    if (!batch.empty()) {
+      flush();
+    }
   }
 
   inline void terminate() {
+    flush_pending();
     forwarder->send(dispatcher, codes::Termination);
   }
 
@@ -114,9 +221,28 @@ public:
     return forwarder->receive_once(handlers, non_blocking);
   }
 
+  inline bool is_full() const {
+    return max_in_flight > 0 && in_flight >= max_in_flight;
+  }
+
+  inline void acknowledge(size_t, size_t n) {
+    in_flight -= n;
+  }
+
 private:
+  inline void flush() {
+    forwarder->send(dispatcher, codes::DataBatch, std::move(batch));
+    in_flight++;
+    batch = std::vector<I>{};
+    batch.reserve(batch_size);
+  }
+
+  // Unit is either a single element `I` or a batch of elements `std::vector<I>`
+  template<typename Unit>
   class Dispatcher : public zaf::ActorBehaviorX {
   public:
+    constexpr static bool is_batch = !std::is_same<Unit, I>::value;
+
     Dispatcher(const std::vector<zaf::Actor>& executors, zaf::Actor res_collector):
       res_collector(res_collector),
       quotas(executors.size()),
@@ -135,28 +261,28 @@ private:
 
     zaf::MessageHandlers behavior() override {
       return {
-        codes::Data - [=](I&& elem) {
+        (is_batch ? codes::DataBatch : codes::Data) - [=](Unit&& unit) {
           if (quotas.empty()) {
-            buffered_elems.emplace_back(std::forward<I>(elem));
+            buffered_units.emplace_back(std::forward<Unit>(unit));
           } else {
             auto w = quotas.back();
-            this->send(executors[w], codes::DataWithQuota, std::forward<I>(elem), w);
+            send_with_quota(w, std::forward<Unit>(unit));
             quotas.pop_back();
           }
         },
         codes::Quota - [=](size_t w) {
-          if (buffered_elems.empty()) {
+          if (buffered_units.empty()) {
             quotas.push_back(w);
           } else {
-            this->send(executors[w], codes::DataWithQuota, std::move(buffered_elems.front()), w);
-            buffered_elems.pop_front();
-            if (buffered_elems.empty() && flag_termination) {
+            send_with_quota(w, std::move(buffered_units.front()));
+            buffered_units.pop_front();
+            if (buffered_units.empty() && flag_termination) {
               terminate();
             }
           }
         },
         codes::Termination - [=]() {
-          if (buffered_elems.empty()) {
+          if (buffered_units.empty()) {
             terminate();
           } else {
             flag_termination = true;
@@ -168,6 +294,11 @@ private:
       };
     }
 
+    inline void send_with_quota(size_t w, Unit&& unit) {
+      this->send(executors[w], is_batch ? codes::DataBatchWithQuota : codes::DataWithQuota,
+        std::forward<Unit>(unit), w);
+    }
+
     void terminate() {
       for (auto& w : executors) {
         this->send(w, codes::Termination);
@@ -177,13 +308,194 @@ private:
 
     zaf::Actor res_collector;
     bool flag_termination = false;
-    std::deque<I> buffered_elems;
+    std::deque<Unit> buffered_units;
     std::vector<size_t> quotas;
     std::vector<zaf::Actor> executors;
   };
 
   zaf::ScopedActor<zaf::ActorBehaviorX> forwarder;
   zaf::Actor dispatcher;
+  size_t batch_size = 1;
+  std::vector<I> batch;
+  size_t max_in_flight = 0;
+  size_t in_flight = 0;
+};
+
+/**
+ * The chunks of elements shared by the forwarder and the executors of `WorkStealing`.
+ *
+ * Each executor owns a deque of chunks. An executor takes chunks from the front of its own deque,
+ * and steals from the back of the others' deques once its own deque is empty.
+ * An executor that finds no chunk anywhere becomes idle and is woken up by `codes::Steal`
+ * when the forwarder pushes a new chunk.
+ **/
+template<typename I>
+class WorkQueues {
+public:
+  explicit WorkQueues(size_t num_executors):
+    queues(num_executors),
+    idle(new std::atomic<bool>[num_executors]) {
+    for (size_t i = 0; i < num_executors; i++) {
+      idle[i].store(false);
+    }
+  }
+
+  // used by forwarder
+  inline void push(size_t w, std::vector<I>&& chunk) {
+    {
+      std::lock_guard<std::mutex> lock(queues[w].mutex);
+      queues[w].chunks.emplace_back(std::move(chunk));
+    }
+    num_chunks.fetch_add(1);
+  }
+
+  // used by forwarder, return an idle executor (starting from `w`) that must be woken up, or -1 if none
+  inline size_t claim_idle(size_t w) {
+    for (size_t k = 0, n = queues.size(); k < n; k++, w = w + 1 == n ? 0 : w + 1) {
+      if (idle[w].load() && idle[w].exchange(false)) {
+        return w;
+      }
+    }
+    return size_t(-1);
+  }
+
+  // used by executor `pid`, keep passing chunks to `f` until no chunk is left or `f` returns false
+  template<typename F>
+  void work(size_t pid, F&& f) {
+    std::vector<I> chunk;
+    while (true) {
+      while (pop(pid, chunk)) {
+        if (!f(chunk)) {
+          return;
+        }
+      }
+      idle[pid].store(true);
+      // a chunk pushed before becoming idle must not be missed
+      if (num_chunks.load() == 0 || !idle[pid].exchange(false)) {
+        // either nothing to do, or the forwarder has claimed this executor and a `codes::Steal` is on the way
+        return;
+      }
+    }
+  }
+
+private:
+  inline bool pop(size_t pid, std::vector<I>& chunk) {
+    for (size_t k = 0, n = queues.size(), w = pid; k < n; k++, w = w + 1 == n ? 0 : w + 1) {
+      auto& q = queues[w];
+      std::lock_guard<std::mutex> lock(q.mutex);
+      if (!q.chunks.empty()) {
+        if (w == pid) {
+          chunk = std::move(q.chunks.front());
+          q.chunks.pop_front();
+        } else {
+          chunk = std::move(q.chunks.back());
+          q.chunks.pop_back();
+        }
+        num_chunks.fetch_sub(1);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  struct Queue {
+    std::mutex mutex;
+    std::deque<std::vector<I>> chunks;
+  };
+
+  std::vector<Queue> queues;
+  std::unique_ptr<std::atomic<bool>[]> idle;
+  std::atomic<size_t> num_chunks{0};
+};
+
+/**
+ * Elements are packed into chunks of `chunk_size` and pushed to the per-executor deques in round-robin,
+ * such that no central dispatcher is involved and idle executors steal the chunks of busy ones.
+ *
+ * Executors receive the shared `WorkQueues` by `codes::Steal` at initialization and every time they are woken up.
+ * On `codes::Termination`, an executor drains all the chunks left before terminating.
+ *
+ * If `max_in_flight` > 0, it is full once `max_in_flight * num_executors` chunks are not acknowledged.
+ **/
+template<typename I>
+class WorkStealing {
+public:
+  WorkStealing(size_t chunk_size):
+    chunk_size(chunk_size) {
+  }
+
+  void initialize(zaf::ActorGroup& group, std::vector<zaf::Actor>& executors, size_t,
+    size_t max_in_flight) {
+    forwarder = group.create_scoped_actor<zaf::ActorBehaviorX>();
+    this->max_in_flight = max_in_flight * executors.size();
+    this->executors = executors;
+    queues = std::make_shared<WorkQueues<I>>(executors.size());
+    chunk.reserve(chunk_size);
+    for (auto& e : executors) {
+      forwarder->send(e, codes::Downstream, forwarder->get_self_actor());
+      forwarder->send(e, codes::Steal, queues);
+    }
+  }
+
+  template<typename U>
+  inline void dispatch(U&& elem) {
+    chunk.emplace_back(std::forward<U>(elem));
+    if (chunk.size() >= chunk_size) {
+      flush();
+    }
+  }
+
+  inline void clear() {
+    forwarder = nullptr;
+    queues = nullptr;
+  }
+
+  inline void flush_pending() {
+    if (!chunk.empty()) {
+      flush();
+    }
+  }
+
+  void terminate() {
+    flush_pending();
+    for (auto& e : executors) {
+      forwarder->send(e, codes::Termination);
+    }
+  }
+
+  inline bool receive(zaf::MessageHandlers& handlers, bool non_blocking) {
+    return forwarder->receive_once(handlers, non_blocking);
+  }
+
+  inline bool is_full() const {
+    return max_in_flight > 0 && in_flight >= max_in_flight;
+  }
+
+  inline void acknowledge(size_t, size_t n) {
+    in_flight -= n;
+  }
+
+private:
+  inline void flush() {
+    queues->push(next_executor, std::move(chunk));
+    in_flight++;
+    auto w = queues->claim_idle(next_executor);
+    if (w != size_t(-1)) {
+      forwarder->send(executors[w], codes::Steal, queues);
+    }
+    next_executor = next_executor + 1 == executors.size() ? 0 : next_executor + 1;
+    chunk = std::vector<I>{};
+    chunk.reserve(chunk_size);
+  }
+
+  std::vector<zaf::Actor> executors;
+  zaf::ScopedActor<zaf::ActorBehaviorX> forwarder;
+  std::shared_ptr<WorkQueues<I>> queues;
+  size_t chunk_size;
+  size_t next_executor = 0;
+  std::vector<I> chunk;
+  size_t max_in_flight = 0;
+  size_t in_flight = 0;
 };
 } // namespace details
 
@@ -215,6 +527,19 @@ struct OnDemandAssign {
   template<typename I>
   inline details::OnDemandAssign<I> create() const { return {}; }
 };
+
+struct WorkStealing {
+  // the number of elements per chunk, which is the unit of work being stolen
+  size_t chunk_size = 64;
+
+  WorkStealing(size_t chunk_size = 64): chunk_size(std::max<size_t>(chunk_size, 1)) {}
+
+  template<typename I>
+  using type = details::WorkStealing<I>;
+
+  template<typename I>
+  inline details::WorkStealing<I> create() const { return {chunk_size}; }
+};
 } // namespace shuffle
 } // namespace coll
 #endif
@@ -1,14 +1,200 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
+#include <iterator>
+#include <limits>
+#include <string>
 #include <vector>
 
 #include "base.hpp"
 #include "container_utils.hpp"
+#include "executor_pool.hpp"
 #include "reference.hpp"
+#include "spill.hpp"
 #include "utils.hpp"
 
 namespace coll {
+namespace sort_utils {
+// The default of `sort().limit(k)`, i.e., all the elements are sorted
+constexpr size_t NoLimit = std::numeric_limits<size_t>::max();
+// With `limit(k)`, the buffered elements are reduced to the first k elements once there are
+// max(k, MinLimitBufferSize) more elements than k
+constexpr size_t MinLimitBufferSize = 1024;
+
+// Below this number of elements per thread, sorting in parallel does not pay off
+constexpr size_t MinParallelSortSizePerThread = 4096;
+// The number of samples taken from each sorted chunk for choosing the splitters
+constexpr size_t NumSamplesPerChunk = 32;
+
+// Run `f(0)` by the calling thread and `f(1)`, ..., `f(lease.size())` by the leased workers
+template<typename F>
+void run_in_parallel(ExecutorPool::Lease& lease, F&& f) {
+  for (size_t i = 0; i < lease.size(); i++) {
+    lease.run(i, [&f, i]() { f(i + 1); });
+  }
+  f(0);
+  lease.wait();
+}
+
+/**
+ * Parallel sorting by regular sampling.
+ * 1. `elems` is divided into `parallelism` chunks, which are sorted by `std::sort` in parallel.
+ * 2. Samples are taken evenly from each sorted chunk, and the splitters are selected evenly from the sorted samples.
+ * 3. The elements of all the chunks between two adjacent splitters are moved to a bucket and merged, in parallel.
+ * Both parallel phases run by the calling thread and `parallelism - 1` workers leased from `pool`.
+ *
+ * Return the buckets, such that the elements in a bucket are ordered before the elements in the next bucket.
+ * `elems` is left with the moved-from elements.
+ **/
+template<typename Container, typename Comparator,
+  typename Elem = traits::remove_cvr_t<decltype(*std::begin(std::declval<Container&>()))>>
+std::vector<std::vector<Elem>> parallel_sort(Container& elems, size_t parallelism, Comparator comparator,
+    ExecutorPool& pool) {
+  auto lease = pool.lease(parallelism - 1);
+  const size_t size = elems.size();
+  auto begin = std::begin(elems);
+  auto chunk_begin = [&](size_t i) {
+    return begin + (size / parallelism * i + std::min(i, size % parallelism));
+  };
+
+  run_in_parallel(lease, [&](size_t i) {
+    std::sort(chunk_begin(i), chunk_begin(i + 1), Comparator(comparator));
+  });
+
+  std::vector<decltype(begin)> samples;
+  samples.reserve(parallelism * NumSamplesPerChunk);
+  for (size_t i = 0; i < parallelism; i++) {
+    auto chunk_size = size_t(chunk_begin(i + 1) - chunk_begin(i));
+    for (size_t k = 1; k <= NumSamplesPerChunk; k++) {
+      samples.push_back(chunk_begin(i) + chunk_size * k / (NumSamplesPerChunk + 1));
+    }
+  }
+  std::sort(samples.begin(), samples.end(), [&](auto& a, auto& b) { return comparator(*a, *b); });
+
+  // bounds[i][j] is the begin of the elements of chunk i that go to bucket j
+  std::vector<std::vector<decltype(begin)>> bounds(parallelism, std::vector<decltype(begin)>(parallelism + 1));
+  for (size_t i = 0; i < parallelism; i++) {
+    bounds[i][0] = chunk_begin(i);
+    bounds[i][parallelism] = chunk_begin(i + 1);
+    for (size_t j = 1; j < parallelism; j++) {
+      auto& splitter = *samples[samples.size() * j / parallelism];
+      bounds[i][j] = std::lower_bound(bounds[i][j - 1], bounds[i][parallelism], splitter, comparator);
+    }
+  }
+
+  std::vector<std::vector<Elem>> buckets(parallelism);
+  run_in_parallel(lease, [&](size_t j) {
+    auto cmp = Comparator(comparator);
+    size_t bucket_size = 0;
+    for (size_t i = 0; i < parallelism; i++) {
+      bucket_size += bounds[i][j + 1] - bounds[i][j];
+    }
+    auto& bucket = buckets[j];
+    bucket.reserve(bucket_size);
+    // the begins of the sorted runs in the bucket
+    std::vector<size_t> runs;
+    for (size_t i = 0; i < parallelism; i++) {
+      runs.push_back(bucket.size());
+      std::move(bounds[i][j], bounds[i][j + 1], std::back_inserter(bucket));
+    }
+    runs.push_back(bucket.size());
+    // merge the runs pairwise until only one is left
+    for (size_t step = 1; step < parallelism; step *= 2) {
+      for (size_t i = 0; i + step < parallelism; i += step * 2) {
+        auto mid = runs[i + step], end = runs[std::min(i + step * 2, parallelism)];
+        std::inplace_merge(bucket.begin() + runs[i], bucket.begin() + mid, bucket.begin() + end, cmp);
+      }
+    }
+  });
+  return buckets;
+}
+
+// Radix sort handles one byte of the keys per pass
+constexpr size_t RadixBits = 8;
+constexpr size_t RadixSize = size_t(1) << RadixBits;
+// Below this number of elements, `std::sort` is used unless radix sort is required by `.radix()`
+constexpr size_t MinRadixSortSize = 1024;
+
+template<typename K>
+struct is_radix_key : public std::integral_constant<bool,
+  std::is_integral<K>::value && !std::is_same<K, bool>::value> {};
+
+// Map an integral key to an unsigned key that has the same order, or the reverse order if `Descending`
+template<bool Descending, typename K>
+inline auto radix_key(K key) {
+  using U = std::make_unsigned_t<K>;
+  auto u = static_cast<U>(key);
+  if constexpr (std::is_signed<K>::value) {
+    u ^= U(1) << (sizeof(U) * 8 - 1);
+  }
+  if constexpr (Descending) {
+    u = static_cast<U>(~u);
+  }
+  return u;
+}
+
+/**
+ * Stable LSD radix sort on the unsigned keys returned by `key_of`.
+ * The counts of all the passes are collected in one scan, and a pass is skipped
+ * if all the keys have the same byte in that pass.
+ **/
+template<typename Iter, typename KeyOf>
+void radix_sort(Iter begin, Iter end, KeyOf key_of) {
+  using Elem = typename std::iterator_traits<Iter>::value_type;
+  using Key = traits::remove_cvr_t<decltype(key_of(*begin))>;
+  static_assert(std::is_unsigned<Key>::value, "Radix sort requires unsigned keys.");
+  constexpr size_t NumPasses = sizeof(Key) * 8 / RadixBits;
+
+  const size_t size = end - begin;
+  if (size <= 1) {
+    return;
+  }
+  auto digit = [&](const Key& key, size_t pass) {
+    return size_t(key >> (pass * RadixBits)) & (RadixSize - 1);
+  };
+
+  std::vector<std::array<size_t, RadixSize>> counts(NumPasses);
+  for (auto& c : counts) {
+    c.fill(0);
+  }
+  for (auto i = begin; i != end; ++i) {
+    Key key = key_of(*i);
+    for (size_t pass = 0; pass < NumPasses; pass++) {
+      counts[pass][digit(key, pass)]++;
+    }
+  }
+
+  std::vector<Elem> buffer(size);
+  bool in_buffer = false;
+  auto scatter = [&](auto from, auto from_end, auto to, size_t pass) {
+    std::array<size_t, RadixSize> offsets;
+    size_t offset = 0;
+    for (size_t d = 0; d < RadixSize; d++) {
+      offsets[d] = offset;
+      offset += counts[pass][d];
+    }
+    for (; from != from_end; ++from) {
+      to[offsets[digit(key_of(*from), pass)]++] = std::move(*from);
+    }
+  };
+  for (size_t pass = 0; pass < NumPasses; pass++) {
+    if (counts[pass][digit(key_of(*begin), pass)] == size) {
+      continue;
+    }
+    if (in_buffer) {
+      scatter(buffer.begin(), buffer.end(), begin, pass);
+    } else {
+      scatter(begin, end, buffer.begin(), pass);
+    }
+    in_buffer = !in_buffer;
+  }
+  if (in_buffer) {
+    std::move(buffer.begin(), buffer.end(), begin);
+  }
+}
+} // namespace sort_utils
+
 template<typename Parent, typename Args>
 struct Sort {
   using InputType = typename Parent::OutputType;
@@ -32,6 +218,13 @@ struct Sort {
     // 2. States, if any
     auto_val(elems, args.template get_buffer<InputType>());
     decltype(std::declval<Child&>().control().forward()) ctrl;
+    using ElemType = traits::remove_cvr_t<decltype(*std::begin(elems))>;
+    // the sorted elements if sorted in parallel
+    std::vector<std::vector<ElemType>> sorted_buckets;
+    // the sorted runs spilled to disk if the memory limit is reached
+    std::vector<spill_utils::SpillFile<ElemType>> runs;
+    static_assert(!Args::is_external || !Args::is_cache_by_ref,
+      "Sort with memory limit does not support cache_by_ref.");
 
     inline auto& control() {
       return ctrl;
@@ -40,24 +233,121 @@ struct Sort {
     // 3. Process each input from parent
     inline void process(InputType e) {
       container_utils::insert(elems, std::forward<InputType>(e));
+      if (args.limit_num != sort_utils::NoLimit) {
+        if (elems.size() > args.limit_num &&
+            elems.size() - args.limit_num >= std::max(args.limit_num, sort_utils::MinLimitBufferSize)) {
+          select_first(args.limit_num);
+        }
+        return;
+      }
+      if constexpr (Args::is_external) {
+        if (elems.size() * sizeof(ElemType) >= args.memory_budget) {
+          spill();
+        }
+      }
+    }
+
+    // sort the buffered elements and write them to disk as a sorted run
+    inline void spill() {
+      sort();
+      runs.emplace_back(args.spill_directory, "coll-sort");
+      auto writer = runs.back().writer();
+      for (auto& e : elems) {
+        writer.write(e);
+      }
+      for (auto& bucket : sorted_buckets) {
+        for (auto& e : bucket) {
+          writer.write(e);
+        }
+      }
+      writer.close();
+      elems.clear();
+      sorted_buckets.clear();
     }
 
     // 4. End
-    inline void sort() {
+    template<typename Comparator>
+    inline void sort(const Comparator& comparator) {
+      if (args.parallelism > 1 &&
+          elems.size() >= args.parallelism * sort_utils::MinParallelSortSizePerThread) {
+        sorted_buckets = sort_utils::parallel_sort(elems, args.parallelism, comparator,
+          args.get_executor_pool());
+        elems.clear();
+      } else {
+        std::sort(elems.begin(), elems.end(), comparator);
+      }
+    }
+
+    template<typename KeyOf>
+    inline void radix_sort(const KeyOf& key_of) {
+      auto elem_key_of = [&](const ElemType& e) {
+        if constexpr (Args::is_cache_by_ref) {
+          return key_of(*e);
+        } else {
+          return key_of(e);
+        }
+      };
+      if constexpr (Args::has_mapper) {
+        // compute the keys once, sort the keys with the indices of the elements, and then rearrange the elements
+        using Key = decltype(elem_key_of(*std::begin(elems)));
+        std::vector<std::pair<Key, size_t>> keys;
+        keys.reserve(elems.size());
+        for (auto& e : elems) {
+          keys.emplace_back(elem_key_of(e), keys.size());
+        }
+        sort_utils::radix_sort(keys.begin(), keys.end(), [](auto& k) { return k.first; });
+        std::vector<ElemType> sorted;
+        sorted.reserve(elems.size());
+        auto begin = std::begin(elems);
+        for (auto& k : keys) {
+          sorted.push_back(std::move(begin[k.second]));
+        }
+        std::move(sorted.begin(), sorted.end(), begin);
+      } else {
+        sort_utils::radix_sort(std::begin(elems), std::end(elems), elem_key_of);
+      }
+    }
+
+    inline auto elem_comparator() {
       using Ctrl = traits::operator_control_t<Child>;
       auto comparator = args.template get_comparator<InputType&, Ctrl::is_reversed>();
       if constexpr (Args::is_cache_by_ref) {
-        std::sort(elems.begin(), elems.end(), [&](auto& ref_a, auto& ref_b) {
+        return [=](auto& ref_a, auto& ref_b) {
           return comparator(*ref_a, *ref_b);
-        });
+        };
       } else {
-        std::sort(elems.begin(), elems.end(), comparator);
+        return comparator;
       }
     }
 
-    inline void end() {
-      sort();
-      for (auto i = elems.begin(), e = elems.end();
+    // keep only the first k elements in order, which are not sorted
+    inline void select_first(size_t k) {
+      if (elems.size() > k) {
+        auto kth = std::begin(elems) + k;
+        std::nth_element(std::begin(elems), kth, std::end(elems), elem_comparator());
+        elems.erase(kth, std::end(elems));
+      }
+    }
+
+    inline void sort() {
+      using Ctrl = traits::operator_control_t<Child>;
+      if (args.limit_num != sort_utils::NoLimit) {
+        select_first(args.limit_num);
+        std::sort(std::begin(elems), std::end(elems), elem_comparator());
+        return;
+      }
+      if constexpr (Args::template use_radix_sort<InputType&>()) {
+        if (Args::is_radix || (args.parallelism == 1 && elems.size() >= sort_utils::MinRadixSortSize)) {
+          radix_sort(args.template get_radix_key<InputType&, Ctrl::is_reversed>());
+          return;
+        }
+      }
+      sort(elem_comparator());
+    }
+
+    template<typename Elems>
+    inline void emit(Elems& sorted) {
+      for (auto i = sorted.begin(), e = sorted.end();
            i != e && !Child::control().break_now; ++i) {
         if constexpr (Args::is_cache_by_ref) {
           Child::process(**i);
@@ -65,10 +355,80 @@ struct Sort {
           Child::process(*i);
         }
       }
+    }
+
+    // k-way merge the spilled runs and the sorted elements in memory
+    inline void merge() {
+      auto comparator = elem_comparator();
+      for (auto& bucket : sorted_buckets) {
+        for (auto& e : bucket) {
+          container_utils::insert(elems, std::move(e));
+        }
+      }
+      sorted_buckets.clear();
+
+      std::vector<typename spill_utils::SpillFile<ElemType>::Reader> readers;
+      std::vector<ElemType> heads(runs.size());
+      readers.reserve(runs.size());
+      for (auto& run : runs) {
+        readers.push_back(run.reader());
+      }
+      // source `runs.size()` is the elements in memory
+      auto in_memory = std::begin(elems);
+      auto head = [&](size_t i) -> ElemType& {
+        return i < readers.size() ? heads[i] : *in_memory;
+      };
+      auto advance = [&](size_t i) {
+        return i < readers.size() ? readers[i].next(heads[i]) : ++in_memory != std::end(elems);
+      };
+      auto greater = [&](size_t a, size_t b) {
+        return comparator(head(b), head(a));
+      };
+      std::vector<size_t> heap;
+      for (size_t i = 0; i < readers.size(); i++) {
+        if (advance(i)) {
+          heap.push_back(i);
+        }
+      }
+      if (in_memory != std::end(elems)) {
+        heap.push_back(readers.size());
+      }
+      std::make_heap(heap.begin(), heap.end(), greater);
+      while (!heap.empty() && !Child::control().break_now) {
+        std::pop_heap(heap.begin(), heap.end(), greater);
+        auto i = heap.back();
+        Child::process(head(i));
+        if (advance(i)) {
+          std::push_heap(heap.begin(), heap.end(), greater);
+        } else {
+          heap.pop_back();
+        }
+      }
+      runs.clear();
+    }
+
+    inline void end() {
+      sort();
+      if constexpr (Args::is_external) {
+        if (!runs.empty()) {
+          merge();
+          Child::end();
+          return;
+        }
+      }
+      emit(elems);
+      for (auto& bucket : sorted_buckets) {
+        emit(bucket);
+      }
       Child::end();
     }
   };
 
+  // Used by the bounded operators that follow, e.g., `take_first(k)` and `head()`
+  inline void limit(size_t k) {
+    args.limit(std::min(args.limit_num, k));
+  }
+
   template<ExecutionType ET, typename Child, typename ... X>
   inline decltype(auto) wrap(X&& ... x) {
     return parent.template wrap<ET, Execution<Child>>(args, std::forward<X>(x)...);
@@ -82,29 +442,46 @@ template<
   typename Comparator = NullArg,
   typename BufferBuilder = NullArg,
   bool CacheByRef = false,
-  bool Reverse = false
+  bool Reverse = false,
+  bool Radix = false,
+  bool External = false
 > struct SortArgs {
   using TagType = SortArgsTag;
 
   // members
   Comparator comparator{};
   BufferBuilder buffer_builder{}; // to be sorted by `std::sort`.
+  size_t parallelism = 1;
+  size_t memory_budget = 0;
+  std::string spill_directory{};
+  size_t limit_num = sort_utils::NoLimit;
+  ExecutorPool* executor_pool = nullptr;
 
   // used by user
-  inline SortArgs<Comparator, BufferBuilder, true, Reverse>
+  inline SortArgs<Comparator, BufferBuilder, true, Reverse, Radix, External>
   cache_by_ref() {
     return {
       std::forward<Comparator>(comparator),
-      std::forward<BufferBuilder>(buffer_builder)
+      std::forward<BufferBuilder>(buffer_builder),
+      parallelism,
+      memory_budget,
+      spill_directory,
+      limit_num,
+      executor_pool
     };
   }
 
   template<typename AnotherBufferBuilder>
-  inline SortArgs<Comparator, AnotherBufferBuilder, CacheByRef, Reverse>
+  inline SortArgs<Comparator, AnotherBufferBuilder, CacheByRef, Reverse, Radix, External>
   buffer(AnotherBufferBuilder&& another_builder) {
     return {
       std::forward<Comparator>(comparator),
-      std::forward<AnotherBufferBuilder>(another_builder)
+      std::forward<AnotherBufferBuilder>(another_builder),
+      parallelism,
+      memory_budget,
+      spill_directory,
+      limit_num,
+      executor_pool
     };
   }
 
@@ -115,16 +492,94 @@ template<
     });
   }
 
-  inline SortArgs<Comparator, BufferBuilder, CacheByRef, true>
+  inline SortArgs<Comparator, BufferBuilder, CacheByRef, true, Radix, External>
   reverse() {
     return {
       std::forward<Comparator>(comparator),
-      std::forward<BufferBuilder>(buffer_builder)
+      std::forward<BufferBuilder>(buffer_builder),
+      parallelism,
+      memory_budget,
+      spill_directory,
+      limit_num,
+      executor_pool
     };
   }
 
+  // Sort by LSD radix sort, which requires the elements, or the keys returned by the mapper, to be integral.
+  // Without `radix()`, radix sort is used only for sorting integral elements without a mapper or comparator.
+  inline SortArgs<Comparator, BufferBuilder, CacheByRef, Reverse, true, External>
+  radix() {
+    return {
+      std::forward<Comparator>(comparator),
+      std::forward<BufferBuilder>(buffer_builder),
+      parallelism,
+      memory_budget,
+      spill_directory,
+      limit_num,
+      executor_pool
+    };
+  }
+
+  /**
+   * Sort with at most about `bytes` of buffered elements, estimated by the size of the element type.
+   * Once the limit is reached, the buffered elements are sorted and written to a temporary file in `spill_dir`
+   * through `Serializer`, and the sorted runs are merged when all the inputs are received.
+   **/
+  inline SortArgs<Comparator, BufferBuilder, CacheByRef, Reverse, Radix, true>
+  memory_limit(size_t bytes) {
+    return {
+      std::forward<Comparator>(comparator),
+      std::forward<BufferBuilder>(buffer_builder),
+      parallelism,
+      std::max<size_t>(bytes, 1),
+      spill_directory,
+      limit_num,
+      executor_pool
+    };
+  }
+
+  // The directory of the temporary files, which is `std::filesystem::temp_directory_path()` by default.
+  inline SortArgs& spill_dir(const std::string& dir) {
+    spill_directory = dir;
+    return *this;
+  }
+
+  /**
+   * Only the first `k` sorted elements are output, which are selected by keeping at most k + max(k, 1024)
+   * elements in the buffer, i.e., O(N + k log k) time and O(k) memory instead of sorting all the N elements.
+   * Parallel sort, radix sort and memory limit do not apply if `k` is given.
+   * `limit` is set automatically if sort is directly followed by `take_first(k)` or `head()`.
+   **/
+  inline SortArgs& limit(size_t k) {
+    limit_num = k;
+    return *this;
+  }
+
+  // Sort by `num_threads` threads if there are enough elements, see `sort_utils::parallel_sort`.
+  inline SortArgs& parallel(size_t num_threads) {
+    parallelism = std::max<size_t>(num_threads, 1);
+    return *this;
+  }
+
+  // The threads of parallel sort are leased from `pool`, or from `parallel_utils::default_executor_pool()` by default.
+  inline SortArgs& execute_by(ExecutorPool& pool) {
+    executor_pool = &pool;
+    return *this;
+  }
+
   // used by operator
+  inline ExecutorPool& get_executor_pool() {
+    if (!executor_pool) {
+      return parallel_utils::default_executor_pool();
+    }
+    return *executor_pool;
+  }
+
   constexpr static bool is_cache_by_ref = CacheByRef;
+  constexpr static bool is_radix = Radix;
+  constexpr static bool is_external = External;
+  // radix sort is by the keys returned by the mapper if any, otherwise by the elements
+  constexpr static bool has_mapper = !std::is_same<Comparator, NullArg>::value;
 
   template<typename Input, bool ControlReverse,
     bool IsComparator = traits::is_invocable<Comparator, Input, Input>::value,
@@ -155,6 +610,38 @@ template<
     }
   }
 
+  template<typename Input,
+    bool IsComparator = traits::is_invocable<Comparator, Input, Input>::value,
+    bool IsMapper = traits::is_invocable<Comparator, Input>::value,
+    bool IsNullArg = std::is_same<Comparator, NullArg>::value>
+  constexpr static bool use_radix_sort() {
+    if constexpr (IsComparator) {
+      static_assert(!Radix, "Radix sort requires a mapper instead of a comparator.");
+      return false;
+    } else if constexpr (IsMapper) {
+      using Key = traits::remove_cvr_t<decltype(std::declval<Comparator&>()(std::declval<Input>()))>;
+      static_assert(!Radix || sort_utils::is_radix_key<Key>::value,
+        "Radix sort requires the mapper to return integral keys.");
+      return Radix;
+    } else if constexpr (IsNullArg) {
+      using Key = traits::remove_cvr_t<Input>;
+      static_assert(!Radix || sort_utils::is_radix_key<Key>::value,
+        "Radix sort requires integral elements.");
+      return sort_utils::is_radix_key<Key>::value;
+    } else {
+      return false;
+    }
+  }
+
+  template<typename Input, bool ControlReverse>
+  inline auto get_radix_key() {
+    if constexpr (std::is_same<Comparator, NullArg>::value) {
+      return [](const auto& e) { return sort_utils::radix_key<Reverse != ControlReverse>(e); };
+    } else {
+      return [=](const auto& e) { return sort_utils::radix_key<Reverse != ControlReverse>(comparator(e)); };
+    }
+  }
+
   template<typename Input,
     typename Elem = std::conditional_t<CacheByRef,
       Reference<traits::remove_vr_t<Input>>,
@@ -0,0 +1,255 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "traits.hpp"
+
+namespace coll {
+/**
+ * The serialization hook of the operators that spill elements to disk, e.g., `sort().memory_limit(bytes)`.
+ *
+ * Trivially copyable types, `std::string` and `std::pair` of serializable types are supported.
+ * Specialize `Serializer<T>` for other types, with
+ *   `static void write(std::ostream& out, const T& e)` and
+ *   `static bool read(std::istream& in, T& e)`, which returns false if there are no more elements.
+ * Spilled elements are read into default-constructed elements.
+ **/
+template<typename T, typename Enable = void>
+struct Serializer;
+
+template<typename T>
+struct Serializer<T, std::enable_if_t<std::is_trivially_copyable<T>::value>> {
+  static inline void write(std::ostream& out, const T& e) {
+    out.write(reinterpret_cast<const char*>(&e), sizeof(T));
+  }
+
+  static inline bool read(std::istream& in, T& e) {
+    return bool(in.read(reinterpret_cast<char*>(&e), sizeof(T)));
+  }
+};
+
+template<typename C, typename Traits, typename Alloc>
+struct Serializer<std::basic_string<C, Traits, Alloc>> {
+  static inline void write(std::ostream& out, const std::basic_string<C, Traits, Alloc>& e) {
+    uint64_t size = e.size();
+    out.write(reinterpret_cast<const char*>(&size), sizeof(size));
+    out.write(reinterpret_cast<const char*>(e.data()), size * sizeof(C));
+  }
+
+  static inline bool read(std::istream& in, std::basic_string<C, Traits, Alloc>& e) {
+    uint64_t size = 0;
+    if (!in.read(reinterpret_cast<char*>(&size), sizeof(size))) {
+      return false;
+    }
+    e.resize(size);
+    return bool(in.read(reinterpret_cast<char*>(&e[0]), size * sizeof(C)));
+  }
+};
+
+template<typename A, typename B>
+struct Serializer<std::pair<A, B>, std::enable_if_t<!std::is_trivially_copyable<std::pair<A, B>>::value>> {
+  static inline void write(std::ostream& out, const std::pair<A, B>& e) {
+    Serializer<std::remove_const_t<A>>::write(out, e.first);
+    Serializer<B>::write(out, e.second);
+  }
+
+  static inline bool read(std::istream& in, std::pair<A, B>& e) {
+    return Serializer<std::remove_const_t<A>>::read(in, const_cast<std::remove_const_t<A>&>(e.first)) &&
+      Serializer<B>::read(in, e.second);
+  }
+};
+
+namespace spill_utils {
+// The size of the stream buffer of each spill file writer or reader
+constexpr size_t SpillBufferSize = 1 << 16;
+
+/**
+ * The estimated bytes of `e` in memory, which count the elements allocated by strings and containers,
+ * e.g., `capacity()` elements of `std::vector` and `size()` nodes of `std::map`.
+ * The memory owned by the elements, e.g., the strings in a vector of strings, is not counted.
+ **/
+template<typename T>
+inline size_t estimated_size(const T& e) {
+  if constexpr (traits::has_capacity<T>::value) {
+    return sizeof(T) + e.capacity() * sizeof(typename T::value_type);
+  } else if constexpr (traits::has_size<T>::value) {
+    // with two pointers per node
+    return sizeof(T) + e.size() * (sizeof(typename T::value_type) + 2 * sizeof(void*));
+  } else {
+    return sizeof(T);
+  }
+}
+
+// The default estimator of the bytes of a (key, value) pair kept in memory by `memory_limit(bytes)`
+struct EstimatedSize {
+  template<typename K, typename V>
+  inline size_t operator()(const K& key, const V& value) const {
+    return estimated_size(key) + estimated_size(value);
+  }
+};
+
+inline std::filesystem::path unique_path(const std::string& dir, const std::string& prefix) {
+  static std::atomic<uint64_t> counter{0};
+  static const auto salt = std::random_device{}();
+  auto parent = dir.empty() ? std::filesystem::temp_directory_path() : std::filesystem::path(dir);
+  return parent / (prefix + "-" + std::to_string(salt) + "-" + std::to_string(counter++));
+}
+
+/**
+ * A temporary file of serialized elements of type `T`, which is removed when the `SpillFile` is destroyed.
+ * Elements are appended by a `Writer` and then read in the same order by `Reader`s.
+ **/
+template<typename T>
+class SpillFile {
+public:
+  class Writer {
+  public:
+    explicit Writer(const std::filesystem::path& path):
+      buffer(SpillBufferSize) {
+      out.rdbuf()->pubsetbuf(buffer.data(), buffer.size());
+      out.open(path, std::ios::binary | std::ios::trunc);
+      if (!out) {
+        throw std::runtime_error("Failed to create spill file " + path.string());
+      }
+    }
+
+    inline void write(const T& e) {
+      Serializer<T>::write(out, e);
+    }
+
+    inline void close() {
+      out.close();
+      if (!out) {
+        throw std::runtime_error("Failed to write spill file.");
+      }
+    }
+
+  private:
+    std::vector<char> buffer;
+    std::ofstream out;
+  };
+
+  class Reader {
+  public:
+    explicit Reader(const std::filesystem::path& path):
+      buffer(SpillBufferSize) {
+      in.rdbuf()->pubsetbuf(buffer.data(), buffer.size());
+      in.open(path, std::ios::binary);
+      if (!in) {
+        throw std::runtime_error("Failed to open spill file " + path.string());
+      }
+    }
+
+    // read the next element into `e`, return false if all the elements are read
+    inline bool next(T& e) {
+      return Serializer<T>::read(in, e);
+    }
+
+  private:
+    std::vector<char> buffer;
+    std::ifstream in;
+  };
+
+  SpillFile(const std::string& dir, const std::string& prefix):
+    path(unique_path(dir, prefix)) {
+  }
+
+  SpillFile(const SpillFile&) = delete;
+  SpillFile& operator=(const SpillFile&) = delete;
+
+  SpillFile(SpillFile&& other):
+    path(std::move(other.path)) {
+    other.path.clear();
+  }
+
+  SpillFile& operator=(SpillFile&& other) {
+    remove();
+    path = std::move(other.path);
+    other.path.clear();
+    return *this;
+  }
+
+  ~SpillFile() {
+    remove();
+  }
+
+  inline Writer writer() const { return Writer(path); }
+  inline Reader reader() const { return Reader(path); }
+
+private:
+  void remove() {
+    if (!path.empty()) {
+      std::error_code ec;
+      std::filesystem::remove(path, ec);
+    }
+  }
+
+  std::filesystem::path path;
+};
+
+// The number of buckets that the elements spilled by a hash table are partitioned into
+constexpr size_t SpillFanout = 16;
+// A bucket is not spilled again beyond this level, e.g., if all the elements of the bucket have the same key
+constexpr size_t MaxSpillLevel = 4;
+
+/**
+ * The elements spilled by a hash table, e.g., `groupby(...).memory_limit(bytes)`, which are partitioned into
+ * `SpillFanout` files by the hashes of their keys. The elements of a key are all in the same bucket,
+ * so each bucket can be processed alone under the same memory limit, or be spilled again at the next level.
+ **/
+template<typename T>
+class SpillBuckets {
+public:
+  SpillBuckets(const std::string& dir, size_t level):
+    dir(dir),
+    level(level),
+    files(SpillFanout),
+    writers(SpillFanout) {
+  }
+
+  inline bool can_spill() const { return level < MaxSpillLevel; }
+  inline size_t next_level() const { return level + 1; }
+
+  inline void write(size_t hash, const T& e) {
+    // each level partitions by the next 4 upper bits of a multiplicative hash, as `SpillFanout` is 16
+    auto b = (uint64_t(hash) * 0x9E3779B97F4A7C15ULL) >> (60 - 4 * level) & (SpillFanout - 1);
+    if (!writers[b]) {
+      files[b] = std::make_unique<SpillFile<T>>(dir, "coll-bucket");
+      writers[b] = std::make_unique<typename SpillFile<T>::Writer>(files[b]->writer());
+    }
+    writers[b]->write(e);
+  }
+
+  // close the writers and take the non-empty buckets
+  inline std::vector<SpillFile<T>> finish() {
+    std::vector<SpillFile<T>> buckets;
+    for (size_t b = 0; b < SpillFanout; b++) {
+      if (writers[b]) {
+        writers[b]->close();
+        writers[b].reset();
+        buckets.push_back(std::move(*files[b]));
+        files[b].reset();
+      }
+    }
+    return buckets;
+  }
+
+private:
+  std::string dir;
+  size_t level;
+  std::vector<std::unique_ptr<SpillFile<T>>> files;
+  std::vector<std::unique_ptr<typename SpillFile<T>::Writer>> writers;
+};
+} // namespace spill_utils
+} // namespace coll
@@ -0,0 +1,364 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSSE3__)
+#include <tmmintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "base.hpp"
+#include "triggers.hpp"
+
+namespace coll {
+/**
+ * A set of delimiter bytes, which classifies 64 bytes at a time into a bitmask of the delimiters.
+ *
+ * With AVX2, a byte b is a delimiter iff lo[b & 15] & hi[b >> 4] != 0, where the 16-entry tables are looked up by
+ * `vpshufb`, and the tables are split for the high nibbles 0-7 and 8-15 such that any set of bytes can be represented.
+ * With SSSE3, the bytes are compared with each delimiter if there are a few delimiters, or otherwise are classified
+ * by the same tables 16 bytes at a time by `pshufb`.
+ * With SSE2 only, the bytes are compared with each delimiter if there are a few delimiters.
+ * Otherwise, the bytes are looked up in a 256-entry table one by one.
+ *
+ * The instruction sets are chosen at compile time. A default x86-64 build has SSE2 only,
+ * see `ENABLE_SSSE3` and `ENABLE_AVX2` in CMakeLists.txt for the others.
+ **/
+class DelimiterSet {
+public:
+  constexpr static size_t MaxComparedDelimiters = 8;
+
+  // e.g., `" \t\n"`
+  explicit DelimiterSet(std::string_view delimiters) {
+    for (auto c : delimiters) {
+      add(uint8_t(c));
+    }
+  }
+
+  // the bytes `c` for which `pred(c)` is true, e.g., `[](char c) { return !std::isalnum((unsigned char) c); }`
+  template<typename Pred,
+    std::enable_if_t<std::is_invocable_r<bool, Pred&, char>::value>* = nullptr>
+  explicit DelimiterSet(Pred pred) {
+    for (int b = 0; b < 256; b++) {
+      if (pred(char(b))) {
+        add(uint8_t(b));
+      }
+    }
+  }
+
+  inline bool contains(char c) const {
+    return table[uint8_t(c)];
+  }
+
+  // the bitmask of the delimiters in the 64 bytes from `p`, where bit i is for p[i]
+  inline uint64_t classify(const char* p) const {
+#if defined(__AVX2__)
+    return classify32(p) | (uint64_t(classify32(p + 32)) << 32);
+#elif defined(__SSE2__)
+    if (num_delimiters <= MaxComparedDelimiters) {
+      uint64_t mask = 0;
+      for (size_t i = 0; i < 64; i += 16) {
+        auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+        auto eq = _mm_setzero_si128();
+        for (size_t j = 0; j < num_delimiters; j++) {
+          eq = _mm_or_si128(eq, _mm_cmpeq_epi8(v, _mm_set1_epi8(char(delimiters[j]))));
+        }
+        mask |= uint64_t(uint16_t(_mm_movemask_epi8(eq))) << i;
+      }
+      return mask;
+    }
+#if defined(__SSSE3__)
+    return uint64_t(classify16(p)) | (uint64_t(classify16(p + 16)) << 16) |
+      (uint64_t(classify16(p + 32)) << 32) | (uint64_t(classify16(p + 48)) << 48);
+#else
+    return classify_scalar(p);
+#endif
+#else
+    return classify_scalar(p);
+#endif
+  }
+
+  /**
+   * Call `f(token)` for each token in [data, data + size), i.e., each maximal run of non-delimiters, until `f`
+   * returns false. Return the offset of the last token if it reaches `size` and thus may continue after `size`,
+   * or `size` if there is no such token, or `std::string_view::npos` if `f` returns false.
+   * The last token is not passed to `f`.
+   **/
+  template<typename F>
+  size_t split(const char* data, size_t size, F&& f) const {
+    bool in_token = false;
+    size_t start = 0;
+    alignas(64) char tail[64];
+    for (size_t base = 0; base < size; base += 64) {
+      uint64_t delims, valid = ~uint64_t(0);
+      if (likely(size - base >= 64)) {
+        delims = classify(data + base);
+      } else {
+        size_t n = size - base;
+        std::memcpy(tail, data + base, n);
+        delims = classify(tail);
+        valid = (uint64_t(1) << n) - 1;
+      }
+      // find the next delimiter in a token, or the next non-delimiter out of a token
+      for (uint64_t from = ~uint64_t(0);;) {
+        uint64_t target = (in_token ? delims : ~delims) & valid & from;
+        if (target == 0) {
+          break;
+        }
+        size_t b = __builtin_ctzll(target);
+        if (in_token) {
+          if (!f(std::string_view(data + start, base + b - start))) {
+            return std::string_view::npos;
+          }
+        } else {
+          start = base + b;
+        }
+        in_token = !in_token;
+        from = ~uint64_t(0) << b;
+      }
+    }
+    return in_token ? start : size;
+  }
+
+private:
+  inline uint64_t classify_scalar(const char* p) const {
+    uint64_t mask = 0;
+    for (size_t i = 0; i < 64; i++) {
+      mask |= uint64_t(table[uint8_t(p[i])]) << i;
+    }
+    return mask;
+  }
+
+#if defined(__AVX2__)
+  inline uint32_t classify32(const char* p) const {
+    auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    auto nibble_mask = _mm256_set1_epi8(0x0f);
+    auto lo = _mm256_and_si256(v, nibble_mask);
+    auto hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), nibble_mask);
+    auto table_of = [](const uint8_t* t) {
+      return _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(t)));
+    };
+    auto cls = _mm256_or_si256(
+      _mm256_and_si256(_mm256_shuffle_epi8(table_of(lo_tables[0]), lo), _mm256_shuffle_epi8(table_of(HiTables[0]), hi)),
+      _mm256_and_si256(_mm256_shuffle_epi8(table_of(lo_tables[1]), lo), _mm256_shuffle_epi8(table_of(HiTables[1]), hi)));
+    return ~uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(cls, _mm256_setzero_si256())));
+  }
+#elif defined(__SSSE3__)
+  inline uint16_t classify16(const char* p) const {
+    auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    auto nibble_mask = _mm_set1_epi8(0x0f);
+    auto lo = _mm_and_si128(v, nibble_mask);
+    auto hi = _mm_and_si128(_mm_srli_epi16(v, 4), nibble_mask);
+    auto table_of = [](const uint8_t* t) {
+      return _mm_loadu_si128(reinterpret_cast<const __m128i*>(t));
+    };
+    auto cls = _mm_or_si128(
+      _mm_and_si128(_mm_shuffle_epi8(table_of(lo_tables[0]), lo), _mm_shuffle_epi8(table_of(HiTables[0]), hi)),
+      _mm_and_si128(_mm_shuffle_epi8(table_of(lo_tables[1]), lo), _mm_shuffle_epi8(table_of(HiTables[1]), hi)));
+    return ~uint16_t(_mm_movemask_epi8(_mm_cmpeq_epi8(cls, _mm_setzero_si128())));
+  }
+#endif
+
+  inline void add(uint8_t b) {
+    if (table[b]) {
+      return;
+    }
+    table[b] = true;
+    delimiters[num_delimiters++] = b;
+    lo_tables[b >> 7][b & 15] |= uint8_t(1) << ((b >> 4) & 7);
+  }
+
+  // the bits of the high nibbles 0-7 and 8-15
+  constexpr static uint8_t HiTables[2][16] = {
+    {1, 2, 4, 8, 16, 32, 64, 128, 0, 0, 0, 0, 0, 0, 0, 0},
+    {0, 0, 0, 0, 0, 0, 0, 0, 1, 2, 4, 8, 16, 32, 64, 128}
+  };
+
+  bool table[256] = {};
+  uint8_t delimiters[256] = {};
+  size_t num_delimiters = 0;
+  // the bits of the high nibbles of the delimiters with each low nibble, for the high nibbles 0-7 and 8-15
+  uint8_t lo_tables[2][16] = {};
+};
+
+namespace split_text_utils {
+constexpr size_t DefaultBlockSize = 1 << 20;
+
+template<typename Child>
+inline void split_text(const DelimiterSet& delimiters, std::string_view text, Child& child) {
+  auto rest = delimiters.split(text.data(), text.size(), [&](std::string_view token) {
+    child.process(token);
+    return !child.control().break_now;
+  });
+  if (rest < text.size()) {
+    child.process(text.substr(rest));
+  }
+}
+} // namespace split_text_utils
+
+/**
+ * Read blocks of text from `in` (or `text`), and output the tokens split by `delimiters` as `std::string_view`s
+ * pointing into the block, which are invalid after the next block is read.
+ * The tokens are maximal runs of non-delimiters, i.e., empty tokens are skipped.
+ * A token that crosses blocks is moved to the front of the next block, and the block grows if a token does not fit.
+ *
+ * The bytes are classified by `DelimiterSet`. In a default x86-64 build, i.e., SSE2 only, at most 8 delimiters are
+ * compared by SIMD, and larger sets, e.g., `[](char c) { return !std::isalnum((unsigned char) c); }`, are looked up
+ * byte by byte. Build with `ENABLE_SSSE3` or `ENABLE_AVX2` to classify any set of delimiters by SIMD.
+ **/
+template<typename Input>
+struct SplitText {
+  using OutputType = std::string_view;
+
+  // `std::istream*` or `std::string_view`
+  Input input;
+  DelimiterSet delimiters;
+  size_t block_size;
+
+  template<typename Child>
+  struct Execution : public Child {
+    using TriggersType = Triggers<Run<>>;
+
+    Input input;
+    DelimiterSet delimiters;
+    size_t block_size;
+
+    template<typename ...X>
+    Execution(const Input& input, const DelimiterSet& delimiters, size_t block_size, X&& ... x):
+      Child(std::forward<X>(x)...),
+      input(input),
+      delimiters(delimiters),
+      block_size(block_size) {
+    }
+
+    inline void run() {
+      if constexpr (std::is_same<Input, std::string_view>::value) {
+        split_text_utils::split_text<Child>(delimiters, input, *this);
+      } else {
+        std::vector<char> block(std::max<size_t>(block_size, 64));
+        // the bytes of the unfinished token at the front of the block
+        size_t num_carried = 0;
+        while (!this->control().break_now) {
+          input->read(block.data() + num_carried, block.size() - num_carried);
+          size_t size = num_carried + input->gcount();
+          if (size < block.size()) {
+            split_text_utils::split_text<Child>(delimiters, {block.data(), size}, *this);
+            return;
+          }
+          auto rest = delimiters.split(block.data(), size, [&](std::string_view token) {
+            Child::process(token);
+            return !this->control().break_now;
+          });
+          if (rest == std::string_view::npos) {
+            return;
+          }
+          num_carried = size - rest;
+          std::memmove(block.data(), block.data() + rest, num_carried);
+          if (num_carried == block.size()) {
+            block.resize(block.size() * 2);
+          }
+        }
+      }
+    }
+  };
+
+  template<ExecutionType ET, typename Child, typename ... X>
+  inline decltype(auto) wrap(X&& ... x) {
+    using Ctrl = traits::operator_control_t<Child>;
+    static_assert(!Ctrl::is_reversed, "SplitText does not support reverse iteration. "
+      "Consider to use `with_buffer()` for the closest downstream `reverse()` operator.");
+
+    if constexpr (ET == Construct) {
+      return Child::template construct<ExecutionType::Execute, Execution<Child>>(
+        input, delimiters, block_size, std::forward<X>(x)...
+      );
+    } else if constexpr (ET == Execute) {
+      return Child::template execute<Execution<Child>>(
+        input, delimiters, block_size, std::forward<X>(x)...
+      );
+    } else {
+      return Execution<Child>(input, delimiters, block_size, std::forward<X>(x)...);
+    }
+  }
+};
+
+// `delimiters` is a string of the delimiters or a predicate on bytes, see `DelimiterSet`
+template<typename Delimiters>
+inline SplitText<std::istream*> split_text(std::istream& in, const Delimiters& delimiters,
+  size_t block_size = split_text_utils::DefaultBlockSize) {
+  return {&in, DelimiterSet(delimiters), block_size};
+}
+
+template<typename Delimiters>
+inline SplitText<std::string_view> split_text(std::string_view text, const Delimiters& delimiters) {
+  return {text, DelimiterSet(delimiters), text.size()};
+}
+
+// split_text as a pipe operator, which splits each input text
+struct SplitTextArgsTag {};
+
+struct SplitTextArgs {
+  using TagType = SplitTextArgsTag;
+
+  DelimiterSet delimiters;
+};
+
+template<typename Delimiters>
+inline SplitTextArgs split_text(const Delimiters& delimiters) {
+  return {DelimiterSet(delimiters)};
+}
+
+template<typename Parent, typename Args>
+struct SplitTextOperator {
+  using InputType = typename Parent::OutputType;
+  using OutputType = std::string_view;
+
+  Parent parent;
+  Args args;
+
+  template<typename Child>
+  struct Execution : public Child {
+    template<typename ...X>
+    Execution(const Args& args, X&& ... x):
+      Child(std::forward<X>(x)...),
+      args(args) {
+    }
+
+    Args args;
+
+    inline void process(InputType e) {
+      split_text_utils::split_text<Child>(args.delimiters, std::string_view(e), *this);
+    }
+  };
+
+  template<ExecutionType ET, typename Child, typename ... X>
+  inline decltype(auto) wrap(X&& ... x) {
+    using Ctrl = traits::operator_control_t<Child>;
+    static_assert(!Ctrl::is_reversed, "SplitText does not support reverse iteration. "
+      "Consider to use `with_buffer()` for the closest downstream `reverse()` operator.");
+
+    return parent.template wrap<ET, Execution<Child>>(
+      args, std::forward<X>(x)...
+    );
+  }
+};
+
+template<typename Parent, typename Args,
+  typename P = traits::remove_cvr_t<Parent>,
+  typename A = traits::remove_cvr_t<Args>,
+  std::enable_if_t<std::is_same<typename A::TagType, SplitTextArgsTag>::value>* = nullptr,
+  std::enable_if_t<traits::is_pipe_operator<P>::value>* = nullptr>
+inline SplitTextOperator<P, A>
+operator | (Parent&& parent, Args&& args) {
+  return {std::forward<Parent>(parent), std::forward<Args>(args)};
+}
+} // namespace coll
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace coll {
+// Used to pad the members accessed by different threads into different cache lines
+constexpr size_t CacheLineSize = 64;
+
+/**
+ * A bounded lock-free queue for exactly one producer thread and one consumer thread.
+ *
+ * Producer: `try_push`
+ * Consumer: `front`, `pop`, `empty`
+ *
+ * The capacity is rounded up to a power of 2 so that the slot of an index can be found by masking.
+ * Each side caches the last seen index of the other side to avoid touching the other side's cache line
+ * unless the queue looks full (for producer) or empty (for consumer).
+ * The queue itself is aligned to cache line such that it does not share cache lines with other objects.
+ **/
+template<typename T>
+class alignas(CacheLineSize) SPSCQueue {
+public:
+  explicit SPSCQueue(size_t capacity):
+    mask(round_up_to_pow2(capacity) - 1),
+    slots(new Slot[mask + 1]) {
+  }
+
+  SPSCQueue(const SPSCQueue<T>&) = delete;
+  SPSCQueue<T>& operator=(const SPSCQueue<T>&) = delete;
+
+  ~SPSCQueue() {
+    while (front()) {
+      pop();
+    }
+  }
+
+  template<typename U>
+  inline bool try_push(U&& e) {
+    auto t = tail.load(std::memory_order_relaxed);
+    if (t - cached_head > mask) {
+      cached_head = head.load(std::memory_order_acquire);
+      if (t - cached_head > mask) {
+        return false;
+      }
+    }
+    new (&slots[t & mask]) T(std::forward<U>(e));
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+  }
+
+  // return the pointer to the first element, or nullptr if the queue is empty
+  inline T* front() {
+    auto h = head.load(std::memory_order_relaxed);
+    if (h == cached_tail) {
+      cached_tail = tail.load(std::memory_order_acquire);
+      if (h == cached_tail) {
+        return nullptr;
+      }
+    }
+    return std::launder(reinterpret_cast<T*>(&slots[h & mask]));
+  }
+
+  // must be called only if `front()` returns non-nullptr
+  inline void pop() {
+    auto h = head.load(std::memory_order_relaxed);
+    std::launder(reinterpret_cast<T*>(&slots[h & mask]))->~T();
+    head.store(h + 1, std::memory_order_release);
+  }
+
+  inline bool empty() {
+    return front() == nullptr;
+  }
+
+  inline size_t capacity() const { return mask + 1; }
+
+private:
+  using Slot = std::aligned_storage_t<sizeof(T), alignof(T)>;
+
+  static size_t round_up_to_pow2(size_t n) {
+    size_t p = 1;
+    while (p < n) {
+      p <<= 1;
+    }
+    return p;
+  }
+
+  const size_t mask;
+  std::unique_ptr<Slot[]> slots;
+
+  // written by consumer
+  alignas(CacheLineSize) std::atomic<size_t> head{0};
+  size_t cached_tail = 0;
+
+  // written by producer
+  alignas(CacheLineSize) std::atomic<size_t> tail{0};
+  size_t cached_head = 0;
+};
+} // namespace coll
@@ -15,10 +15,18 @@ struct TakeWhileArgs {
 template<typename F>
 inline TakeWhileArgs<F> take_while(F lambda) { return {lambda}; }
 
-inline auto take_first(size_t num) {
-  return take_while([num](auto&&) mutable {
+// The filter of `take_first`, which lets the parent know that only the first `num` elements are needed
+struct TakeFirst {
+  size_t num;
+
+  template<typename E>
+  inline bool operator()(E&&) {
     return num--;
-  });
+  }
+};
+
+inline TakeWhileArgs<TakeFirst> take_first(size_t num) {
+  return take_while(TakeFirst{num});
 }
 
 template<typename Parent, typename Args>
@@ -63,7 +71,13 @@ template<typename Parent, typename Args,
   std::enable_if_t<traits::is_pipe_operator<P>::value>* = nullptr>
 inline TakeWhile<P, A>
 operator | (Parent&& parent, Args&& args) {
-  return {std::forward<Parent>(parent), std::forward<Args>(args)};
+  if constexpr (std::is_same<A, TakeWhileArgs<TakeFirst>>::value && traits::has_limit<P>::value) {
+    P limited(std::forward<Parent>(parent));
+    limited.limit(args.filter.num);
+    return {std::move(limited), std::forward<Args>(args)};
+  } else {
+    return {std::forward<Parent>(parent), std::forward<Args>(args)};
+  }
 }
 } // namespace coll
 
@@ -0,0 +1,261 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <limits>
+#include <optional>
+#include <ostream>
+#include <type_traits>
+#include <vector>
+
+#include "base.hpp"
+
+namespace coll {
+// the elements of a window in [begin_time, end_time) in the order of time
+template<typename Elem, typename Time>
+struct TimeWindowedElements {
+  Time begin_time{};
+  Time end_time{};
+  std::vector<Elem> elems;
+
+  inline auto begin() const { return elems.begin(); }
+  inline auto end() const { return elems.end(); }
+  inline size_t size() const { return elems.size(); }
+  inline const Elem& operator[](size_t idx) const { return elems[idx]; }
+
+  friend std::ostream& operator<<(std::ostream& out, const TimeWindowedElements<Elem, Time>& w) {
+    out << '[' << w.begin_time << ", " << w.end_time << "): [";
+    for (size_t i = 0; i < w.elems.size(); i++) {
+      out << (i == 0 ? "" : ", ") << w.elems[i];
+    }
+    return out << ']';
+  }
+};
+
+struct TimeWindowArgsTag {};
+
+template<typename TimeFn, typename Duration, bool Session>
+struct TimeWindowArgs {
+  using TagType = TimeWindowArgsTag;
+  using DurationType = Duration;
+
+  TimeFn time_fn;
+  // the length of the windows, or the gap of the sessions
+  Duration length;
+  Duration slide;
+  Duration lateness{};
+
+  // Wait for the elements that are at most `l` later than the max time seen so far.
+  inline auto& allowed_lateness(Duration l) {
+    lateness = l;
+    return *this;
+  }
+
+  constexpr static bool is_session = Session;
+};
+
+/**
+ * Window the elements by the time of `time_fn(e)` into windows of `length` every `slide`,
+ * where the windows are aligned to time 0 and only the non-empty windows are output.
+ * The windows that start before the lowest time of the type are not output, e.g., those before 0 for unsigned times.
+ *
+ * A window is output as soon as the watermark, i.e., the max time seen minus the allowed lateness, passes its end.
+ * The elements of the windows already output are dropped, so the buffered elements are bounded by
+ * the elements of `length + lateness`.
+ **/
+template<typename TimeFn, typename Duration>
+inline TimeWindowArgs<TimeFn, Duration, false> window_by_time(TimeFn time_fn, Duration length, Duration slide) {
+  return {std::forward<TimeFn>(time_fn), length, slide};
+}
+
+template<typename TimeFn, typename Duration>
+inline TimeWindowArgs<TimeFn, Duration, false> window_by_time(TimeFn time_fn, Duration length) {
+  return window_by_time(std::forward<TimeFn>(time_fn), length, length);
+}
+
+/**
+ * Window the elements into sessions, where a session ends if no element arrives in `gap` after its last element.
+ * A session in [time of the first element, time of the last element + gap) is output as soon as the watermark passes
+ * its end, and the elements of the sessions already output are dropped, see `window_by_time`.
+ **/
+template<typename TimeFn, typename Duration>
+inline TimeWindowArgs<TimeFn, Duration, true> session_window(TimeFn time_fn, Duration gap) {
+  return {std::forward<TimeFn>(time_fn), gap, gap};
+}
+
+template<typename Parent, typename Args>
+struct WindowByTime {
+  using InputType = typename Parent::OutputType;
+  using ElemType = traits::remove_cvr_t<InputType>;
+  using TimeType = std::common_type_t<
+    traits::remove_cvr_t<decltype(std::declval<Args&>().time_fn(std::declval<const ElemType&>()))>,
+    typename Args::DurationType
+  >;
+  static_assert(std::is_arithmetic<TimeType>::value, "The time of elements is expected to be arithmetic.");
+  using WindowType = TimeWindowedElements<ElemType, TimeType>;
+  using OutputType = const WindowType&;
+
+  Parent parent;
+  Args args;
+
+  template<typename Child>
+  struct Execution : public Child {
+    template<typename ...X>
+    Execution(const Args& args, X&& ... x):
+      Child(std::forward<X>(x)...),
+      args(args) {
+    }
+
+    Args args;
+    // the elements not output yet in the order of time
+    std::deque<std::pair<TimeType, ElemType>> buffer;
+    WindowType window;
+    std::optional<TimeType> max_time;
+    // the elements before which are dropped, i.e., the start of the next window or the end of the last session
+    std::optional<TimeType> lower_bound;
+    // the number of the earliest buffered elements known to be in the first session,
+    // which only grows until the session is output as an inserted element never splits a session
+    size_t session_size = 0;
+
+    inline void process(InputType e) {
+      TimeType t = args.time_fn(e);
+      if (lower_bound && t < *lower_bound) {
+        return;
+      }
+      if (buffer.empty() || !(t < buffer.back().first)) {
+        buffer.emplace_back(t, std::forward<InputType>(e));
+      } else {
+        auto pos = std::upper_bound(buffer.begin(), buffer.end(), t,
+          [](auto& t, auto& p) { return t < p.first; });
+        if (size_t(pos - buffer.begin()) < session_size) {
+          ++session_size;
+        }
+        buffer.emplace(pos, t, std::forward<InputType>(e));
+      }
+      if (!max_time || *max_time < t) {
+        max_time = t;
+        output(subtract(t, TimeType(args.lateness)), false);
+      }
+    }
+
+    inline void end() {
+      output(TimeType(), true);
+      Child::end();
+    }
+
+    // output the windows that end no later than `watermark`, or all the windows if `flush`
+    inline void output(TimeType watermark, bool flush) {
+      while (!buffer.empty() && !this->control().break_now) {
+        if constexpr (Args::is_session) {
+          auto i = buffer.begin() + std::max<size_t>(session_size, 1);
+          for (; i != buffer.end() && i->first < (i - 1)->first + TimeType(args.length); ++i);
+          session_size = i - buffer.begin();
+          TimeType end = (i - 1)->first + TimeType(args.length);
+          if (!flush && watermark < end) {
+            return;
+          }
+          window.begin_time = buffer.front().first;
+          window.end_time = end;
+          window.elems.clear();
+          for (auto j = buffer.begin(); j != i; ++j) {
+            window.elems.emplace_back(std::move(j->second));
+          }
+          buffer.erase(buffer.begin(), i);
+          session_size = 0;
+          lower_bound = end;
+        } else {
+          // the first window that contains the earliest buffered element
+          TimeType start = first_start(buffer.front().first);
+          if (lower_bound && start < *lower_bound) {
+            start = *lower_bound;
+          }
+          // the element is in no window, i.e., in the gap between two windows when `slide` > `length`
+          if (buffer.front().first < start) {
+            buffer.pop_front();
+            continue;
+          }
+          TimeType end = start + TimeType(args.length);
+          if (!flush && watermark < end) {
+            return;
+          }
+          window.begin_time = start;
+          window.end_time = end;
+          window.elems.clear();
+          // the elements before the next window are moved, and the others are copied
+          TimeType next_start = start + TimeType(args.slide);
+          auto i = buffer.begin();
+          for (; i != buffer.end() && i->first < end; ++i) {
+            if (i->first < next_start) {
+              window.elems.emplace_back(std::move(i->second));
+            } else {
+              window.elems.emplace_back(i->second);
+            }
+          }
+          buffer.erase(buffer.begin(), std::find_if(buffer.begin(), i,
+            [&](auto& p) { return !(p.first < next_start); }));
+          lower_bound = next_start;
+        }
+        Child::process(window);
+      }
+    }
+
+    // `t - d`, or the lowest time if it is lower, e.g., instead of wrapping around for unsigned times
+    inline static TimeType subtract(TimeType t, TimeType d) {
+      if constexpr (std::is_integral<TimeType>::value) {
+        if (t < std::numeric_limits<TimeType>::lowest() + d) {
+          return std::numeric_limits<TimeType>::lowest();
+        }
+      }
+      return t - d;
+    }
+
+    // the start of the first window that contains `t`, i.e., the smallest multiple of `slide` larger than `t - length`
+    inline TimeType first_start(TimeType t) const {
+      TimeType slide = args.slide;
+      if constexpr (std::is_integral<TimeType>::value) {
+        // the smallest multiple of `slide` that is no lower than the lowest time
+        if (t < std::numeric_limits<TimeType>::lowest() + TimeType(args.length)) {
+          return std::numeric_limits<TimeType>::lowest() / slide * slide;
+        }
+      }
+      return align(t - TimeType(args.length)) + slide;
+    }
+
+    // the largest multiple of `slide` that is no larger than `t`
+    inline TimeType align(TimeType t) const {
+      TimeType slide = args.slide;
+      if constexpr (std::is_integral<TimeType>::value) {
+        TimeType q = t / slide;
+        if (t % slide != 0 && (t < 0) != (slide < 0)) {
+          --q;
+        }
+        return q * slide;
+      } else {
+        return std::floor(t / slide) * slide;
+      }
+    }
+  };
+
+  template<ExecutionType ET, typename Child, typename ... X>
+  inline decltype(auto) wrap(X&& ... x) {
+    using Ctrl = traits::operator_control_t<Child>;
+    static_assert(!Ctrl::is_reversed, "Window does not support reverse iteration. "
+      "Consider to use `with_buffer()` for the closest downstream `reverse()` operator.");
+
+    return parent.template wrap<ET, Execution<Child>>(
+      args, std::forward<X>(x)...
+    );
+  }
+};
+
+template<typename Parent, typename Args,
+  typename P = traits::remove_cvr_t<Parent>,
+  typename A = traits::remove_cvr_t<Args>,
+  std::enable_if_t<std::is_same<typename A::TagType, TimeWindowArgsTag>::value>* = nullptr,
+  std::enable_if_t<traits::is_pipe_operator<P>::value>* = nullptr>
+inline WindowByTime<P, A>
+operator | (Parent&& parent, Args&& args) {
+  return {std::forward<Parent>(parent), std::forward<Args>(args)};
+}
+} // namespace coll
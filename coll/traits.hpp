@@ -4,6 +4,7 @@
 #include <optional>
 #include <string_view>
 #include <utility>
+#include <vector>
 
 #include "utils.hpp"
 
@@ -93,6 +94,46 @@ auto has_emplace_impl(int) -> decltype(
 template<typename C, typename E>
 std::false_type has_emplace_impl(...);
 
+template<typename C>
+auto has_capacity_impl(int) -> decltype(
+  std::declval<const C&>().capacity(),
+  std::declval<typename C::value_type>(),
+  std::declval<typename C::allocator_type>(),
+  std::true_type{}
+);
+
+template<typename C>
+std::false_type has_capacity_impl(...);
+
+template<typename C>
+auto has_size_impl(int) -> decltype(
+  std::declval<const C&>().size(),
+  std::declval<typename C::value_type>(),
+  std::declval<typename C::allocator_type>(),
+  std::true_type{}
+);
+
+template<typename C>
+std::false_type has_size_impl(...);
+
+template<typename T>
+auto has_merge_impl(int) -> decltype(
+  std::declval<T&>().merge(std::declval<T&>()),
+  std::true_type{}
+);
+
+template<typename T>
+std::false_type has_merge_impl(...);
+
+template<typename P>
+auto has_limit_impl(int) -> decltype(
+  std::declval<P&>().limit(size_t{}),
+  std::true_type{}
+);
+
+template<typename P>
+std::false_type has_limit_impl(...);
+
 template<typename T, typename E>
 auto is_builder_impl(int) -> decltype(
   std::declval<T&>()(Type<E>{}),
@@ -162,6 +203,16 @@ struct iterator {
   using element_t = decltype(*std::declval<I&>());
 };
 
+// whether the elements of the iterator are adjacent in memory, i.e., pointers and the iterators of `std::vector`
+template<typename I, typename V = typename std::iterator_traits<I>::value_type>
+struct is_contiguous_iterator : std::integral_constant<
+  bool,
+  std::is_pointer<I>::value || (!std::is_same<V, bool>::value && (
+    std::is_same<I, typename std::vector<V>::iterator>::value ||
+    std::is_same<I, typename std::vector<V>::const_iterator>::value
+  ))
+> {};
+
 // https://stackoverflow.com/questions/24855160/how-to-tell-if-a-c-template-type-is-c-style-string
 template<class T>
 struct is_c_str : std::integral_constant<
@@ -188,6 +239,22 @@ using has_push = decltype(details::has_push_impl<C, E>(0));
 template<typename C, typename E>
 using has_emplace = decltype(details::has_emplace_impl<C, E>(0));
 
+// whether the container allocates `capacity()` elements by its allocator, e.g., `std::vector` and `std::string`
+template<typename C>
+using has_capacity = decltype(details::has_capacity_impl<C>(0));
+
+// whether the container allocates `size()` elements by its allocator, e.g., `std::list` and `std::map`
+template<typename C>
+using has_size = decltype(details::has_size_impl<C>(0));
+
+// whether `a.merge(b)` merges b into a, e.g., sketches
+template<typename T>
+using has_merge = decltype(details::has_merge_impl<T>(0));
+
+// whether the pipe operator can be told that only its first k outputs are needed, e.g., `Sort`
+template<typename P>
+using has_limit = decltype(details::has_limit_impl<P>(0));
+
 template<class T>
 struct is_bounded_array: std::false_type {};
 
@@ -1,25 +1,56 @@
 #pragma once
 
+#include <memory>
+
 #include "base.hpp"
+#include "iterate.hpp"
 #include "reference.hpp"
+#include "window_aggregate.hpp"
 #include "windowed_elements.hpp"
 
 namespace coll {
 struct WindowArgsTag {};
 
-// Note(zzxx): May consider pushing `size` and `step` to the template arguements
-// but not sure what the benefit is for doing so
-template<bool CacheByRef>
+// See `FixedWindowArgs` for `size` and `step` known at compile time.
+template<bool CacheByRef, bool AsView = false>
 struct WindowArgs {
   using TagType = WindowArgsTag;
 
+  constexpr static bool is_view = AsView;
+
   size_t size;
   size_t step;
 
-  inline WindowArgs<true> cache_by_ref() {
+  inline WindowArgs<true, AsView> cache_by_ref() {
+    return {size, step};
+  }
+
+  /**
+   * Output the windows as `ContiguousWindow`s, i.e., views of the source without copying the elements,
+   * which requires a contiguous source, e.g., `iterate(vector)`, `iterate(array)` or `iterate(string)`.
+   * A `ContiguousWindow` provides `size()`, `operator[]`, `begin()`, `end()` and `data()`,
+   * but not the other members of `WindowedElements`.
+   **/
+  inline WindowArgs<CacheByRef, true> as_view() {
     return {size, step};
   }
 
+  /**
+   * Output the aggregate of each window instead of the window, which is updated incrementally per element,
+   * e.g., `window(1000, 1).aggregate(window_ops::max())` for rolling maxima, see `window_ops`.
+   * `op` can also be an associative reducer, e.g., `[](auto& a, auto&& b) { a *= b; }`.
+   **/
+  template<typename Op>
+  inline auto aggregate(Op op) {
+    static_assert(!CacheByRef, "Window aggregate caches the elements by value.");
+    static_assert(!AsView, "Window aggregate does not output the windows.");
+    if constexpr (window_ops::is_window_op<Op>::value) {
+      return WindowAggregateArgs<Op>{size, step, std::forward<Op>(op)};
+    } else {
+      return aggregate(window_ops::reduce(std::forward<Op>(op)));
+    }
+  }
+
   template<typename InputType>
   using WindowType = WindowedElements<InputType, CacheByRef>;
 
@@ -27,19 +58,111 @@ struct WindowArgs {
   inline WindowType<InputType> create_window() { return {size, step}; }
 };
 
+/**
+ * Output the windows of `size` elements that start every `step` elements as `WindowedElements`,
+ * which cache the elements by value, or by reference after `cache_by_ref()`.
+ * Use `as_view()` on a contiguous source to output the windows as views of the source instead.
+ **/
 inline WindowArgs<false> window(size_t size, size_t step) { return {size, step}; }
 
 inline WindowArgs<false> window(size_t size) { return {size, size}; }
 
+/**
+ * `window<Size, Step>()` outputs the same windows as `window(Size, Step)`, but the window is kept in a `std::array`
+ * located by masking, and the loops on the window, e.g., `for (size_t i = 0; i < Size; i++) sum += w[i];`,
+ * can be unrolled and vectorized by the compiler.
+ **/
+template<size_t Size, size_t Step, bool CacheByRef>
+struct FixedWindowArgs {
+  using TagType = WindowArgsTag;
+
+  constexpr static bool is_view = false;
+  constexpr static size_t size = Size;
+  constexpr static size_t step = Step;
+
+  inline FixedWindowArgs<Size, Step, true> cache_by_ref() {
+    return {};
+  }
+
+  template<typename InputType>
+  using WindowType = FixedWindowedElements<InputType, Size, Step, CacheByRef>;
+
+  template<typename InputType>
+  inline WindowType<InputType> create_window() { return {}; }
+};
+
+template<size_t Size, size_t Step = Size>
+inline FixedWindowArgs<Size, Step, false> window() {
+  static_assert(Size != 0 && Step != 0, "The size and the step of windows are expected to be positive.");
+  return {};
+}
+
+namespace window_utils {
+template<typename Parent>
+struct is_contiguous_source : std::false_type {};
+
+template<typename Iter>
+struct is_contiguous_source<IterateByIterator<Iter>> : traits::is_contiguous_iterator<Iter> {};
+} // namespace window_utils
+
 template<typename Parent, typename Args>
 struct Window {
   using InputType = typename Parent::OutputType;
-  using WindowType = typename Args::template WindowType<InputType>;
+  // With `as_view()`, the windows are views of the contiguous source, e.g., `iterate(vector)`, without copying elements.
+  constexpr static bool is_contiguous = Args::is_view;
+  static_assert(!is_contiguous || window_utils::is_contiguous_source<Parent>::value,
+    "`window(...).as_view()` expects a contiguous source, e.g., `iterate(vector)`.");
+  using WindowType = std::conditional_t<is_contiguous,
+    ContiguousWindow<const traits::remove_vr_t<InputType>>,
+    typename Args::template WindowType<InputType>
+  >;
   using OutputType = const WindowType&;
 
   Parent parent;
   Args args;
 
+  template<typename Child>
+  struct ContiguousExecution : public Child {
+    using TriggersType = Triggers<Run<>>;
+
+    template<typename ...X>
+    ContiguousExecution(const Args& args, const Parent& source, X&& ... x):
+      Child(std::forward<X>(x)...),
+      args(args),
+      w(source.left == source.right ? nullptr : std::addressof(*source.left), 0),
+      num_elems(source.right - source.left) {
+    }
+
+    Args args;
+    WindowType w;
+    size_t num_elems;
+
+    // the same windows as `WindowedElements`
+    inline void run() {
+      auto data = w.data();
+      if (num_elems < args.size) {
+        if (num_elems != 0) {
+          w = WindowType(data, num_elems);
+          Child::process(w);
+        }
+        return;
+      }
+      size_t start = 0;
+      for (; start + args.size <= num_elems; start += args.step) {
+        if (this->control().break_now) {
+          return;
+        }
+        w = WindowType(data + start, args.size);
+        Child::process(w);
+      }
+      // the remaining elements after the last window, if the last window does not end with the last element
+      if (start - args.step + args.size != num_elems && start < num_elems && !this->control().break_now) {
+        w = WindowType(data + start, num_elems - start);
+        Child::process(w);
+      }
+    }
+  };
+
   template<typename Child>
   struct Execution : public Child {
     template<typename ...X>
@@ -81,9 +204,23 @@ struct Window {
     static_assert(!Ctrl::is_reversed, "Window does not support reverse iteration. "
       "Consider to use `with_buffer()` for the closest downstream `reverse()` operator.");
 
-    return parent.template wrap<ET, Execution<Child>>(
-      args, std::forward<X>(x)...
-    );
+    if constexpr (is_contiguous) {
+      if constexpr (ET == Construct) {
+        return Child::template construct<ExecutionType::Execute, ContiguousExecution<Child>>(
+          args, parent, std::forward<X>(x)...
+        );
+      } else if constexpr (ET == Execute) {
+        return Child::template execute<ContiguousExecution<Child>>(
+          args, parent, std::forward<X>(x)...
+        );
+      } else {
+        return ContiguousExecution<Child>(args, parent, std::forward<X>(x)...);
+      }
+    } else {
+      return parent.template wrap<ET, Execution<Child>>(
+        args, std::forward<X>(x)...
+      );
+    }
   }
 };
 
@@ -0,0 +1,334 @@
+#pragma once
+
+#include <deque>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "base.hpp"
+
+namespace coll {
+/**
+ * The aggregators of sliding windows, each of which keeps the aggregate of a FIFO window of elements,
+ * where `push` appends the newest element, `pop` evicts the oldest element, and `result` gets the aggregate.
+ * All of them take O(1) amortized time per element.
+ **/
+namespace window_ops {
+struct WindowOpTag {};
+
+template<typename Elem>
+struct CountAggregator {
+  size_t cnt = 0;
+
+  template<typename U>
+  inline void push(U&&) { ++cnt; }
+  inline void pop() { --cnt; }
+  inline size_t result() { return cnt; }
+};
+
+// For invertible ops, e.g., sum, the aggregate is updated by `add` on push and by `remove` on pop.
+template<typename Elem, typename Acc, typename Add, typename Remove, typename Result>
+struct InvertibleAggregator {
+  Acc acc;
+  Add add;
+  Remove remove;
+  Result res;
+  std::deque<Elem> elems;
+
+  template<typename U>
+  inline void push(U&& e) {
+    add(acc, e);
+    elems.emplace_back(std::forward<U>(e));
+  }
+
+  inline void pop() {
+    remove(acc, elems.front());
+    elems.pop_front();
+  }
+
+  inline auto result() { return res(acc, elems.size()); }
+};
+
+/**
+ * For associative ops, the window is split into two stacks.
+ * The front stack keeps the aggregates of the suffixes of the older elements, i.e., its top aggregates them all,
+ * and the back stack keeps the newer elements together with their aggregate.
+ * A pop on an empty front stack moves the elements of the back stack to the front stack.
+ **/
+template<typename Elem, typename Reducer>
+struct TwoStackAggregator {
+  Reducer reducer;
+  std::vector<Elem> front;
+  std::vector<Elem> back;
+  std::optional<Elem> back_agg;
+
+  template<typename U>
+  inline void push(U&& e) {
+    if (back_agg) {
+      reducer(*back_agg, e);
+    } else {
+      back_agg = e;
+    }
+    back.emplace_back(std::forward<U>(e));
+  }
+
+  inline void pop() {
+    if (front.empty()) {
+      for (auto i = back.rbegin(); i != back.rend(); ++i) {
+        if (!front.empty()) {
+          reducer(*i, front.back());
+        }
+        front.emplace_back(std::move(*i));
+      }
+      back.clear();
+      back_agg.reset();
+    }
+    front.pop_back();
+  }
+
+  inline Elem result() {
+    if (front.empty()) {
+      return *back_agg;
+    }
+    if (!back_agg) {
+      return front.back();
+    }
+    Elem agg = front.back();
+    reducer(agg, *back_agg);
+    return agg;
+  }
+};
+
+// For min and max, the window keeps the elements that are better than all the newer ones, the oldest being the best.
+template<typename Elem, typename Comparator>
+struct MonotonicAggregator {
+  Comparator comparator;
+  std::deque<std::pair<size_t, Elem>> candidates;
+  size_t num_pushed = 0;
+  size_t num_popped = 0;
+
+  template<typename U>
+  inline void push(U&& e) {
+    while (!candidates.empty() && !comparator(candidates.back().second, e)) {
+      candidates.pop_back();
+    }
+    candidates.emplace_back(num_pushed++, std::forward<U>(e));
+  }
+
+  inline void pop() {
+    if (candidates.front().first == num_popped++) {
+      candidates.pop_front();
+    }
+  }
+
+  inline Elem result() { return candidates.front().second; }
+};
+
+struct CountOp {
+  using TagType = WindowOpTag;
+
+  template<typename Elem>
+  inline auto create() { return CountAggregator<Elem>{}; }
+};
+
+template<typename Init, typename Add, typename Remove, typename Result>
+struct InvertibleOp {
+  using TagType = WindowOpTag;
+
+  Init init;
+  Add add;
+  Remove remove;
+  Result res;
+
+  template<typename Elem>
+  inline auto create() {
+    if constexpr (traits::is_builder<Init, Elem>::value) {
+      using Acc = decltype(init(Type<Elem>{}));
+      return InvertibleAggregator<Elem, Acc, Add, Remove, Result>{init(Type<Elem>{}), add, remove, res, {}};
+    } else {
+      return InvertibleAggregator<Elem, Init, Add, Remove, Result>{init, add, remove, res, {}};
+    }
+  }
+};
+
+template<typename Reducer>
+struct ReduceOp {
+  using TagType = WindowOpTag;
+
+  Reducer reducer;
+
+  template<typename Elem>
+  inline auto create() { return TwoStackAggregator<Elem, Reducer>{reducer, {}, {}, {}}; }
+};
+
+template<typename Comparator>
+struct MonotonicOp {
+  using TagType = WindowOpTag;
+
+  Comparator comparator;
+
+  template<typename Elem>
+  inline auto create() { return MonotonicAggregator<Elem, Comparator>{comparator, {}}; }
+};
+
+template<typename Op, typename = void>
+struct is_window_op : std::false_type {};
+
+template<typename Op>
+struct is_window_op<Op, std::enable_if_t<
+  std::is_same<typename Op::TagType, WindowOpTag>::value
+>> : std::true_type {};
+
+inline CountOp count() { return {}; }
+
+/**
+ * `init` is the aggregate of no elements or a builder of it, `add(acc, e)` adds `e` to `acc`,
+ * `remove(acc, e)` removes `e` from `acc`, and `result(acc, n)` gets the output from `acc` of `n` elements.
+ **/
+template<typename Init, typename Add, typename Remove, typename Result>
+inline InvertibleOp<Init, Add, Remove, Result> invertible(Init init, Add add, Remove remove, Result result) {
+  return {std::forward<Init>(init), std::forward<Add>(add), std::forward<Remove>(remove), std::forward<Result>(result)};
+}
+
+template<typename Init, typename Add, typename Remove>
+inline auto invertible(Init init, Add add, Remove remove) {
+  return invertible(std::forward<Init>(init), std::forward<Add>(add), std::forward<Remove>(remove),
+    [](auto& acc, size_t) { return acc; });
+}
+
+inline auto sum() {
+  return invertible(
+    [](auto type) { return typename decltype(type)::type{}; },
+    [](auto& acc, auto& e) { acc += e; },
+    [](auto& acc, auto& e) { acc -= e; });
+}
+
+inline auto avg() {
+  return invertible(
+    [](auto type) { return typename decltype(type)::type{}; },
+    [](auto& acc, auto& e) { acc += e; },
+    [](auto& acc, auto& e) { acc -= e; },
+    [](auto& acc, size_t n) {
+      auto avg = acc;
+      if constexpr (std::is_arithmetic<traits::remove_cvr_t<decltype(acc)>>::value) {
+        return avg /= decltype(avg)(n);
+      } else {
+        return avg /= n;
+      }
+    });
+}
+
+// `reducer(a, b)` reduces `b` to `a`, where `b` is newer than `a`.
+template<typename Reducer>
+inline ReduceOp<Reducer> reduce(Reducer reducer) {
+  return {std::forward<Reducer>(reducer)};
+}
+
+template<typename Comparator>
+inline MonotonicOp<Comparator> max(Comparator comp) {
+  return {std::forward<Comparator>(comp)};
+}
+
+template<typename Comparator>
+inline MonotonicOp<Comparator> min(Comparator comp) {
+  return {std::forward<Comparator>(comp)};
+}
+
+inline auto max() {
+  return max([](auto&& a, auto&& b) { return b < a; });
+}
+
+inline auto min() {
+  return min([](auto&& a, auto&& b) { return a < b; });
+}
+} // namespace window_ops
+
+struct WindowAggregateArgsTag {};
+
+template<typename Op>
+struct WindowAggregateArgs {
+  using TagType = WindowAggregateArgsTag;
+  using OpType = Op;
+
+  size_t size;
+  size_t step;
+  Op op;
+};
+
+template<typename Parent, typename Args>
+struct WindowAggregate {
+  using InputType = typename Parent::OutputType;
+  using ElemType = traits::remove_cvr_t<InputType>;
+  using AggregatorType = decltype(std::declval<typename Args::OpType&>().template create<ElemType>());
+  using OutputType = decltype(std::declval<AggregatorType&>().result());
+
+  Parent parent;
+  Args args;
+
+  template<typename Child>
+  struct Execution : public Child {
+    template<typename ...X>
+    Execution(const Args& args, X&& ... x):
+      Child(std::forward<X>(x)...),
+      args(args) {
+    }
+
+    Args args;
+    auto_val(aggregator, args.op.template create<ElemType>());
+    size_t num_elems = 0;
+    size_t cur_steps = args.size;
+
+    inline void process(InputType e) {
+      if (num_elems == args.size) {
+        aggregator.pop();
+      } else {
+        ++num_elems;
+      }
+      aggregator.push(std::forward<InputType>(e));
+      if (--cur_steps == 0) {
+        cur_steps = args.step;
+        Child::process(aggregator.result());
+      }
+    }
+
+    // the same as `WindowedElements::pack_remaining_elements`
+    inline void end() {
+      if (num_elems < args.size) {
+        if (num_elems != 0) {
+          Child::process(aggregator.result());
+        }
+      } else if (cur_steps != args.step) {
+        for (; cur_steps != 0 && num_elems != 0; --cur_steps, --num_elems) {
+          aggregator.pop();
+        }
+        if (num_elems != 0) {
+          Child::process(aggregator.result());
+        }
+      }
+      Child::end();
+    }
+  };
+
+  template<ExecutionType ET, typename Child, typename ... X>
+  inline decltype(auto) wrap(X&& ... x) {
+    using Ctrl = traits::operator_control_t<Child>;
+    static_assert(!Ctrl::is_reversed, "Window does not support reverse iteration. "
+      "Consider to use `with_buffer()` for the closest downstream `reverse()` operator.");
+
+    return parent.template wrap<ET, Execution<Child>>(
+      args, std::forward<X>(x)...
+    );
+  }
+};
+
+template<typename Parent, typename Args,
+  typename P = traits::remove_cvr_t<Parent>,
+  typename A = traits::remove_cvr_t<Args>,
+  std::enable_if_t<std::is_same<typename A::TagType, WindowAggregateArgsTag>::value>* = nullptr,
+  std::enable_if_t<traits::is_pipe_operator<P>::value>* = nullptr>
+inline WindowAggregate<P, A>
+operator | (Parent&& parent, Args&& args) {
+  return {std::forward<Parent>(parent), std::forward<Args>(args)};
+}
+} // namespace coll
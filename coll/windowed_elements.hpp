@@ -1,5 +1,6 @@
 #pragma once
 
+#include <array>
 #include <ostream>
 #include <vector>
 
@@ -8,6 +9,38 @@
 
 namespace coll {
 
+// the iterator of the elements of a window, which are located by `owner.get_by_abs_idx`
+template<typename OwnerType>
+struct WindowIterator {
+  OwnerType& owner;
+  size_t abs_idx;
+
+  WindowIterator<OwnerType>& operator++() {
+    ++abs_idx;
+    return *this;
+  }
+
+  WindowIterator<OwnerType> operator++(int) {
+    return {owner, abs_idx++};
+  }
+
+  inline friend bool operator==(const WindowIterator<OwnerType>& a, const WindowIterator<OwnerType>& b) {
+    return a.abs_idx == b.abs_idx;
+  }
+
+  inline friend bool operator!=(const WindowIterator<OwnerType>& a, const WindowIterator<OwnerType>& b) {
+    return a.abs_idx != b.abs_idx;
+  }
+
+  inline auto& operator*() {
+    return owner.get_by_abs_idx(abs_idx);
+  }
+
+  inline auto operator->() {
+    return &owner.get_by_abs_idx(abs_idx);
+  }
+};
+
 template<typename I, bool CacheByRef>
 struct WindowedElements {
 public:
@@ -77,39 +110,116 @@ public:
     return get_by_abs_idx(idx + start_idx - num_elems);
   }
 
-  template<typename OwnerType>
-  struct inner_iterator {
-    OwnerType& owner;
-    size_t abs_idx;
+  template<typename> friend struct WindowIterator;
+  using iterator = WindowIterator<WindowedElements<I, CacheByRef>>;
+  using const_iterator = WindowIterator<const WindowedElements<I, CacheByRef>>;
+
+  inline auto begin() { return iterator{*this, start_idx - num_elems}; }
+  inline auto begin() const { return const_iterator{*this, start_idx - num_elems}; }
+
+  inline auto end() { return iterator{*this, start_idx}; }
+  inline auto end() const { return const_iterator{*this, start_idx}; }
+
+  inline size_t size() const { return num_elems; }
 
-    inner_iterator<OwnerType>& operator++() {
-      ++abs_idx;
-      return *this;
+  bool pack_remaining_elements() {
+    if (elems.size() < window_size) {
+      return !elems.empty();
     }
+    if (cur_steps == step) {
+      return false;
+    }
+    num_elems -= std::min(num_elems, cur_steps);
+    return num_elems != 0;
+  }
 
-    inner_iterator<OwnerType> operator++(int) {
-      return {owner, abs_idx++};
+  friend std::ostream& operator<<(std::ostream& out, const WindowedElements<I, CacheByRef>& w) {
+    auto i = w.begin(), e = w.end();
+    if (i != e) {
+      out << '[' << *i;
+      for (++i; i != e; ++i) {
+        out << ", " << *i;
+      }
+      out << ']';
+    } else {
+      out << "[]";
     }
+    return out;
+  }
+};
+
+/**
+ * The same as `WindowedElements` but with `Size` and `Step` known at compile time.
+ * The elements are kept in a `std::array` whose size is rounded up to a power of two,
+ * such that the elements are located by masking instead of `%`.
+ **/
+template<typename I, size_t Size, size_t Step, bool CacheByRef>
+struct FixedWindowedElements {
+public:
+  using ElemType = std::conditional_t<CacheByRef,
+    Reference<traits::remove_vr_t<I>>,
+    traits::remove_cvr_t<I>
+  >;
+  static_assert(std::is_default_constructible<ElemType>::value,
+    "The elements of a fixed window are expected to be default constructible.");
 
-    inline friend bool operator==(const inner_iterator<OwnerType>& a, const inner_iterator<OwnerType>& b) {
-      return a.abs_idx == b.abs_idx;
+  constexpr static size_t Capacity = [] {
+    size_t c = 1;
+    while (c < Size) {
+      c <<= 1;
     }
+    return c;
+  }();
+  constexpr static size_t Mask = Capacity - 1;
 
-    inline friend bool operator!=(const inner_iterator<OwnerType>& a, const inner_iterator<OwnerType>& b) {
-      return a.abs_idx != b.abs_idx;
+private:
+  std::array<ElemType, Capacity> elems{};
+  size_t start_idx = 0;
+  size_t cur_steps = Size;
+  size_t num_elems = 0;
+
+  inline auto& get_by_abs_idx(size_t abs_idx) {
+    if constexpr (CacheByRef) {
+      return *elems[abs_idx & Mask];
+    } else {
+      return elems[abs_idx & Mask];
     }
+  }
 
-    inline auto& operator*() {
-      return owner.get_by_abs_idx(abs_idx);
+  inline const auto& get_by_abs_idx(size_t abs_idx) const {
+    if constexpr (CacheByRef) {
+      return *elems[abs_idx & Mask];
+    } else {
+      return elems[abs_idx & Mask];
     }
+  }
 
-    inline auto operator->() {
-      return &owner.get_by_abs_idx(abs_idx);
+public:
+  // return `true` when the `cur_steps` is dropped to 0
+  // then `cur_steps` will be reset to `Step`
+  template<typename U>
+  inline bool emplace(U&& in) {
+    elems[start_idx & Mask] = std::forward<U>(in);
+    start_idx++;
+    num_elems += num_elems < Size;
+    if (--cur_steps == 0) {
+      cur_steps = Step;
+      return true;
     }
-  };
+    return false;
+  }
 
-  using iterator = inner_iterator<WindowedElements<I, CacheByRef>>;
-  using const_iterator = inner_iterator<const WindowedElements<I, CacheByRef>>;
+  inline auto& operator[](size_t idx) {
+    return get_by_abs_idx(idx + start_idx - num_elems);
+  }
+
+  inline const auto& operator[](size_t idx) const {
+    return get_by_abs_idx(idx + start_idx - num_elems);
+  }
+
+  template<typename> friend struct WindowIterator;
+  using iterator = WindowIterator<FixedWindowedElements<I, Size, Step, CacheByRef>>;
+  using const_iterator = WindowIterator<const FixedWindowedElements<I, Size, Step, CacheByRef>>;
 
   inline auto begin() { return iterator{*this, start_idx - num_elems}; }
   inline auto begin() const { return const_iterator{*this, start_idx - num_elems}; }
@@ -117,20 +227,21 @@ public:
   inline auto end() { return iterator{*this, start_idx}; }
   inline auto end() const { return const_iterator{*this, start_idx}; }
 
+  // `Size` except for the last window
   inline size_t size() const { return num_elems; }
 
   bool pack_remaining_elements() {
-    if (elems.size() < window_size) {
-      return !elems.empty();
+    if (start_idx < Size) {
+      return num_elems != 0;
     }
-    if (cur_steps == step) {
+    if (cur_steps == Step) {
       return false;
     }
     num_elems -= std::min(num_elems, cur_steps);
     return num_elems != 0;
   }
 
-  friend std::ostream& operator<<(std::ostream& out, const WindowedElements<I, CacheByRef>& w) {
+  friend std::ostream& operator<<(std::ostream& out, const FixedWindowedElements<I, Size, Step, CacheByRef>& w) {
     auto i = w.begin(), e = w.end();
     if (i != e) {
       out << '[' << *i;
@@ -145,4 +256,39 @@ public:
   }
 };
 
+// A view of a window whose elements are adjacent in the source, e.g., a window of a `std::vector`.
+template<typename T>
+struct ContiguousWindow {
+public:
+  ContiguousWindow(T* data, size_t size):
+    ptr(data),
+    num_elems(size) {
+  }
+
+  inline T& operator[](size_t idx) const { return ptr[idx]; }
+
+  inline T* begin() const { return ptr; }
+  inline T* end() const { return ptr + num_elems; }
+  inline T* data() const { return ptr; }
+
+  inline size_t size() const { return num_elems; }
+
+  friend std::ostream& operator<<(std::ostream& out, const ContiguousWindow<T>& w) {
+    if (w.num_elems != 0) {
+      out << '[' << w.ptr[0];
+      for (size_t i = 1; i < w.num_elems; i++) {
+        out << ", " << w.ptr[i];
+      }
+      out << ']';
+    } else {
+      out << "[]";
+    }
+    return out;
+  }
+
+private:
+  T* ptr;
+  size_t num_elems;
+};
+
 } // namespace coll
@@ -7,11 +7,16 @@ int main() {
   int K = 5;
 
   auto topk_freq_words_of_diff_lens = 
-    // read char stream from std::cin
-    coll::iterate(std::istreambuf_iterator<char>(std::cin.rdbuf()), {})
-      | coll::map(anony_cc(char(std::tolower(_))))
-      // split the char stream into strings
-      | coll::split(std::string(), anony_cc(!std::isalnum(_) && _ != '_'))
+    // read std::cin by blocks and split the text into words
+    coll::split_text(std::cin, anony_cc(!std::isalnum((unsigned char) _) && _ != '_'))
+      // the words point into the block being read, so copy them
+      | coll::map([](std::string_view word) {
+          std::string str(word);
+          for (auto& c : str) {
+            c = char(std::tolower((unsigned char) c));
+          }
+          return str;
+        })
       // group string and count occurrences, have to process all inputs before we know the count of a string
       | coll::groupby(anony_ac(_)).count()
       | coll::iterate()
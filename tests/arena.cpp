@@ -0,0 +1,94 @@
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "coll/coll.hpp"
+
+// counts the allocations that the arena takes from upstream
+class CountingResource : public std::pmr::memory_resource {
+public:
+  size_t num_allocations = 0;
+
+private:
+  void* do_allocate(size_t bytes, size_t alignment) override {
+    ++num_allocations;
+    return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+  }
+
+  void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+    std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+  }
+
+  bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+    return this == &other;
+  }
+};
+
+GTEST_TEST(Arena, HashTable) {
+  CountingResource upstream;
+  coll::Arena arena(1 << 20, &upstream);
+
+  coll::NodeHashMap<int, std::pmr::string> map(&arena);
+  EXPECT_EQ(map.memory_resource(), &arena);
+  for (int i = 0; i < 1000; i++) {
+    map.emplace(i, std::to_string(i));
+  }
+  map.erase(0);
+  EXPECT_EQ(map.size(), 999u);
+  EXPECT_EQ(map.at(999), "999");
+
+  // a copy allocates from the same arena
+  auto copy = map;
+  EXPECT_EQ(copy.memory_resource(), &arena);
+  EXPECT_EQ(copy, map);
+
+  // nodes and slots are all taken from the initial block
+  EXPECT_EQ(upstream.num_allocations, 1u);
+}
+
+GTEST_TEST(Arena, Pipeline) {
+  std::vector<std::string> words;
+  coll::range(10000)
+    | coll::map(anony_cc(std::to_string(rand() % 1000)))
+    | coll::to(words);
+
+  auto expected_distinct = coll::iterate(words)
+    | coll::distinct()
+    | coll::sort()
+    | coll::to<std::vector>();
+  auto expected_groups = coll::iterate(words)
+    | coll::groupby(anony_rc(_.size()))
+        .count();
+
+  CountingResource upstream;
+  coll::Arena arena(1 << 20, &upstream);
+
+  auto sorted_distinct = coll::iterate(words)
+    | coll::distinct(arena.containers<coll::FlatHashSet>())
+    | coll::sort().buffer(arena.containers<std::pmr::vector>())
+    | coll::to<std::vector>();
+  EXPECT_EQ(sorted_distinct, expected_distinct);
+
+  auto groups = coll::iterate(words)
+    | coll::groupby(anony_rc(_.size()))
+        .with_map(arena.maps<coll::FlatHashMap>())
+        .count();
+  EXPECT_EQ(groups.memory_resource(), &arena);
+  EXPECT_EQ(groups, expected_groups);
+
+  auto sizes = coll::iterate(words)
+    | coll::partition([](auto&, auto in) {
+        return in | coll::count();
+      })
+      .by(anony_rc(_.size()))
+      .with_map(arena.maps<coll::NodeHashMap>())
+    | coll::to<std::vector>();
+  EXPECT_EQ(sizes.size(), groups.size());
+  for (auto& [size, cnt] : sizes) {
+    EXPECT_EQ(groups.at(size), cnt);
+  }
+
+  EXPECT_EQ(upstream.num_allocations, 1u);
+}
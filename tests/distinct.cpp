@@ -100,3 +100,35 @@ TEST_F(Distinct, UsingGoatRef) {
   EXPECT_EQ(ScapegoatCounter::num_scapegoat_copy, 0);
   EXPECT_EQ(ScapegoatCounter::num_scapegoat_move, 0);
 }
+
+TEST_F(Distinct, Approx) {
+  auto expected = coll::iterate(Distinct::ints)
+    | coll::distinct()
+    | coll::count();
+  auto outputs = coll::iterate(Distinct::ints)
+    | coll::distinct().approx(0.01, expected)
+    | coll::to<std::vector>();
+  // no duplicates but may miss some distinct elements as false positives
+  auto distinct_outputs = coll::iterate(outputs)
+    | coll::distinct()
+    | coll::count();
+  EXPECT_EQ(distinct_outputs, outputs.size());
+  EXPECT_LE(outputs.size(), expected);
+  EXPECT_GE(outputs.size(), expected * 0.95);
+}
+
+GTEST_TEST(BlockedBloomFilter, FalsePositiveRate) {
+  for (double fp_rate : {0.01, 0.001}) {
+    const int n = 100000;
+    coll::BlockedBloomFilter bloom(n, fp_rate);
+    for (int i = 0; i < n; i++) {
+      bloom.insert(i);
+    }
+    int num_fp = 0;
+    for (int i = 0; i < n; i++) {
+      EXPECT_TRUE(bloom.may_contain(i));
+      num_fp += bloom.may_contain(n + i);
+    }
+    EXPECT_LE(num_fp, n * fp_rate);
+  }
+}
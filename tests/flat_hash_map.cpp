@@ -0,0 +1,99 @@
+#include <string>
+#include <unordered_map>
+
+#include "gtest/gtest.h"
+
+#include "coll/coll.hpp"
+
+#include "scapegoat.hpp"
+
+GTEST_TEST(FlatHashMap, InsertFindErase) {
+  coll::FlatHashMap<int, int> map;
+  std::unordered_map<int, int> expected;
+  for (int i = 0; i < 100000; i++) {
+    int key = rand() % 20000;
+    map[key] += i;
+    expected[key] += i;
+    if (i % 3 == 0) {
+      key = rand() % 20000;
+      EXPECT_EQ(map.erase(key), expected.erase(key));
+    }
+  }
+  EXPECT_EQ(map.size(), expected.size());
+  for (auto& kv : expected) {
+    auto iter = map.find(kv.first);
+    ASSERT_NE(iter, map.end());
+    EXPECT_EQ(iter->second, kv.second);
+  }
+  size_t num_iterated = 0;
+  for (auto& kv : map) {
+    EXPECT_EQ(expected.at(kv.first), kv.second);
+    ++num_iterated;
+  }
+  EXPECT_EQ(num_iterated, expected.size());
+  EXPECT_EQ(map.count(-1), 0u);
+  EXPECT_THROW(map.at(-1), std::out_of_range);
+
+  auto copy = map;
+  EXPECT_TRUE(copy == map);
+  map.clear();
+  EXPECT_TRUE(map.empty());
+  EXPECT_EQ(map.begin(), map.end());
+  EXPECT_EQ(copy.size(), expected.size());
+}
+
+GTEST_TEST(FlatHashMap, NonTrivialTypes) {
+  coll::FlatHashMap<std::string, Scapegoat> map;
+  for (int i = 0; i < 1000; i++) {
+    EXPECT_TRUE(map.emplace(std::to_string(i), Scapegoat{i}).second);
+  }
+  EXPECT_FALSE(map.emplace(std::string("1"), Scapegoat{-1}).second);
+  for (int i = 0; i < 1000; i += 2) {
+    map.erase(std::to_string(i));
+  }
+  EXPECT_EQ(map.size(), 500u);
+  for (int i = 1; i < 1000; i += 2) {
+    EXPECT_EQ(map.at(std::to_string(i)).val, i);
+  }
+
+  coll::FlatHashSet<std::string> set;
+  EXPECT_TRUE(set.insert("a").second);
+  EXPECT_FALSE(set.insert("a").second);
+  EXPECT_TRUE(set.contains("a"));
+}
+
+GTEST_TEST(FlatHashMap, NodeStability) {
+  coll::NodeHashMap<int, int> map;
+  auto* first = &map[0];
+  for (int i = 1; i < 10000; i++) {
+    map[i] = i;
+  }
+  EXPECT_EQ(first, &map[0]);
+}
+
+GTEST_TEST(FlatHashMap, Operators) {
+  auto counts = coll::range(10000)
+    | coll::map(anony_cc(_ % 100))
+    | coll::groupby().count();
+  EXPECT_TRUE((std::is_same<decltype(counts), coll::FlatHashMap<int, size_t>>::value));
+  EXPECT_EQ(counts.size(), 100u);
+  EXPECT_EQ(counts.at(42), 100u);
+
+  auto std_counts = coll::range(10000)
+    | coll::map(anony_cc(_ % 100))
+    | coll::groupby().with_map<std::unordered_map>().count();
+  EXPECT_TRUE((std::is_same<decltype(std_counts), std::unordered_map<int, size_t>>::value));
+  EXPECT_EQ(std_counts.at(42), 100u);
+
+  std::vector<Scapegoat> goats;
+  coll::range(1000)
+    | coll::map(anony_cc(Scapegoat{_ % 10}))
+    | coll::to(goats);
+  ScapegoatCounter::clear();
+  auto num_distinct = coll::iterate(goats)
+    | coll::distinct().cache_by_ref()
+    | coll::count();
+  EXPECT_EQ(num_distinct, 10u);
+  EXPECT_EQ(ScapegoatCounter::num_scapegoat_copy, 0);
+  EXPECT_EQ(ScapegoatCounter::num_scapegoat_move, 0);
+}
@@ -0,0 +1,221 @@
+#include <filesystem>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "coll/coll.hpp"
+
+#include "scapegoat.hpp"
+
+class GroupBy : public ::testing::Test {
+public:
+  inline static std::vector<int> ints;
+
+protected:
+  static void SetUpTestSuite() {
+    coll::range(100000)
+      | coll::map(anony_cc(rand() % 1000))
+      | coll::to(ints);
+  }
+
+  static void TearDownTestSuite() {}
+};
+
+TEST_F(GroupBy, ParallelCount) {
+  auto expected = coll::iterate(GroupBy::ints)
+    | coll::groupby(anony_rc(_ % 100))
+        .count();
+  auto counts = coll::iterate(GroupBy::ints)
+    | coll::groupby(anony_rc(_ % 100))
+        .count()
+        .parallel(4);
+  EXPECT_EQ(counts, expected);
+
+  auto single_thread_counts = coll::iterate(GroupBy::ints)
+    | coll::groupby(anony_rc(_ % 100))
+        .count()
+        .parallel(1);
+  EXPECT_EQ(single_thread_counts, expected);
+}
+
+TEST_F(GroupBy, ParallelExecuteBy) {
+  auto expected = coll::iterate(GroupBy::ints)
+    | coll::groupby(anony_rc(_ % 100))
+        .count();
+  // the threads are leased from the pool and given back for the next execution
+  coll::ExecutorPool pool(2);
+  for (int i = 0; i < 3; i++) {
+    auto counts = coll::iterate(GroupBy::ints)
+      | coll::groupby(anony_rc(_ % 100))
+          .count()
+          .parallel(4)
+          .batch(100)
+          .execute_by(pool);
+    EXPECT_EQ(counts, expected);
+    EXPECT_EQ(pool.num_workers(), 4u);
+    EXPECT_EQ(pool.num_idle_workers(), 4u);
+  }
+}
+
+TEST_F(GroupBy, ParallelToVector) {
+  auto groups = coll::iterate(GroupBy::ints)
+    | coll::groupby(anony_rc(std::to_string(_ % 10)))
+        .to_vector()
+        .parallel(3)
+        .batch(100);
+  EXPECT_EQ(groups.size(), 10u);
+  size_t total = 0;
+  for (auto& g : groups) {
+    for (auto& v : g.second) {
+      EXPECT_EQ(std::to_string(v % 10), g.first);
+    }
+    total += g.second.size();
+  }
+  EXPECT_EQ(total, GroupBy::ints.size());
+}
+
+TEST_F(GroupBy, ParallelCombine) {
+  auto expected = coll::iterate(GroupBy::ints)
+    | coll::groupby(anony_rc(_ % 7))
+        .aggregate(0, [](auto& max, auto v) { max = std::max(max, v); });
+  auto maxes = coll::iterate(GroupBy::ints)
+    | coll::groupby(anony_rc(_ % 7))
+        .aggregate(0, [](auto& max, auto v) { max = std::max(max, v); })
+        .parallel(4)
+        .combine([](auto& max, auto&& another_max) { max = std::max(max, another_max); });
+  EXPECT_EQ(maxes, expected);
+}
+
+TEST_F(GroupBy, ParallelApproxCountDistinct) {
+  auto expected = coll::iterate(GroupBy::ints)
+    | coll::groupby(anony_rc(_ % 10))
+        .approx_count_distinct();
+  // the sketches of the threads are combined by `HyperLogLog::merge`
+  auto sketches = coll::iterate(GroupBy::ints)
+    | coll::groupby(anony_rc(_ % 10))
+        .approx_count_distinct()
+        .parallel(4);
+  EXPECT_EQ(sketches, expected);
+}
+
+TEST_F(GroupBy, ParallelQuantiles) {
+  auto sorted = coll::iterate(GroupBy::ints)
+    | coll::groupby(anony_rc(_ % 10))
+        .to_vector();
+  // the sketches of the threads are combined by `KllSketch::merge`
+  auto sketches = coll::iterate(GroupBy::ints)
+    | coll::groupby(anony_rc(_ % 10))
+        .quantiles()
+        .parallel(4);
+  EXPECT_EQ(sketches.size(), sorted.size());
+  for (auto& [k, values] : sorted) {
+    std::sort(values.begin(), values.end());
+    auto& kll = sketches.at(k);
+    EXPECT_EQ(kll.size(), values.size());
+    for (auto q : {0.1, 0.5, 0.99}) {
+      EXPECT_NEAR(kll.quantile(q), values[size_t(q * values.size())], 1000 * 0.02);
+    }
+  }
+}
+
+TEST_F(GroupBy, ParallelCacheByRef) {
+  std::vector<Scapegoat> goats;
+  coll::iterate(GroupBy::ints)
+    | coll::map(anony_rc(Scapegoat{_}))
+    | coll::to(goats);
+
+  ScapegoatCounter::clear();
+  auto groups = coll::iterate(goats)
+    | coll::groupby(anony_rc(_.val % 5))
+        .cache_by_ref()
+        .to_vector()
+        .parallel(2);
+  EXPECT_EQ(ScapegoatCounter::num_scapegoat_copy, 0);
+  EXPECT_EQ(groups.size(), 5u);
+  for (auto& g : groups) {
+    for (auto& ref : g.second) {
+      EXPECT_EQ(ref->val % 5, g.first);
+    }
+  }
+}
+
+TEST_F(GroupBy, ExternalCount) {
+  auto dir = std::filesystem::temp_directory_path() / "coll-external-groupby-test";
+  std::filesystem::create_directories(dir);
+
+  auto expected = coll::iterate(GroupBy::ints)
+    | coll::groupby()
+        .count();
+  // about 100 groups in memory, so most of the 1000 keys are spilled
+  auto counts = coll::iterate(GroupBy::ints)
+    | coll::external_groupby(coll::groupby().count(), 100 * (sizeof(int) + sizeof(size_t)))
+        .spill_dir(dir.string())
+    | coll::to<std::unordered_map<int, size_t>>();
+  EXPECT_EQ(counts.size(), expected.size());
+  for (auto& g : expected) {
+    EXPECT_EQ(counts[g.first], g.second);
+  }
+  EXPECT_TRUE(std::filesystem::is_empty(dir));
+
+  std::filesystem::remove(dir);
+}
+
+TEST_F(GroupBy, ExternalEstimatedSize) {
+  auto dir = std::filesystem::temp_directory_path() / "coll-external-groupby-size-test";
+  std::filesystem::create_directories(dir);
+
+  auto groups = [&](auto groupby) {
+    // whether some groups were spilled when the groups in memory are output
+    bool spilled = false;
+    size_t num_groups = 0;
+    coll::range(10000)
+      | groupby.spill_dir(dir.string())
+      | coll::foreach([&](auto&& g) {
+          if (num_groups++ == 0) {
+            spilled = !std::filesystem::is_empty(dir);
+          }
+          EXPECT_EQ(g.second.size(), 1000u);
+        });
+    EXPECT_EQ(num_groups, 10u);
+    return spilled;
+  };
+
+  // the groups of 1000 elements are larger than 4096 bytes as their elements are counted,
+  // so the keys after the first group are spilled
+  EXPECT_TRUE(groups(coll::external_groupby(coll::groupby(anony_cc(_ / 1000)).to_vector(), 4096)));
+  EXPECT_FALSE(groups(coll::external_groupby(coll::groupby(anony_cc(_ / 1000)).to_vector(), 1 << 20)));
+  EXPECT_TRUE(groups(coll::external_groupby(coll::groupby(anony_cc(std::to_string(_ / 1000))).to_vector(),
+    1 << 20, [](auto&, auto& g) { return g.size() * 1024; })));
+  EXPECT_TRUE(std::filesystem::is_empty(dir));
+
+  std::filesystem::remove(dir);
+}
+
+TEST_F(GroupBy, ExternalToVector) {
+  // only 1 group is kept in memory at each level, so the other groups are spilled until the maximum level
+  auto groups = coll::iterate(GroupBy::ints)
+    | coll::external_groupby(coll::groupby(anony_rc(std::to_string(_ % 10)))
+        .valueby(anony_rc(std::to_string(_)))
+        .to_vector(), 1)
+    | coll::to<std::map<std::string, std::vector<std::string>>>();
+  auto expected = coll::iterate(GroupBy::ints)
+    | coll::groupby(anony_rc(std::to_string(_ % 10)))
+        .valueby(anony_rc(std::to_string(_)))
+        .to_vector();
+  EXPECT_EQ(groups.size(), 10u);
+  for (auto& g : expected) {
+    // the elements of each group are in the order of arrival
+    EXPECT_EQ(groups[g.first], g.second);
+  }
+
+  auto last = coll::iterate(GroupBy::ints)
+    | coll::external_groupby(coll::groupby(anony_rc(_ % 10)), 1)
+    | coll::to<std::map<int, int>>();
+  std::map<int, int> expected_last;
+  for (auto i : GroupBy::ints) {
+    expected_last[i % 10] = i;
+  }
+  EXPECT_EQ(last, expected_last);
+}
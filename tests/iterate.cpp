@@ -58,3 +58,23 @@ GTEST_TEST(Iterate, Optional) {
     | coll::foreach(anonyr_av(r = _));
   EXPECT_FALSE(bool(r));
 }
+
+GTEST_TEST(Iterate, Split) {
+  auto vec = std::vector<int>{1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+  auto iters = coll::iterate(vec).split(4);
+  ASSERT_EQ(iters.size(), 4u);
+  EXPECT_EQ(iters[0] | coll::to<std::vector>(), (std::vector<int>{1, 2, 3}));
+  EXPECT_EQ(iters[1] | coll::to<std::vector>(), (std::vector<int>{4, 5, 6}));
+  EXPECT_EQ(iters[2] | coll::to<std::vector>(), (std::vector<int>{7, 8}));
+  EXPECT_EQ(iters[3] | coll::to<std::vector>(), (std::vector<int>{9, 10}));
+
+  auto ranges = coll::range(1, 10, 3).split(2);
+  ASSERT_EQ(ranges.size(), 2u);
+  EXPECT_EQ(ranges[0] | coll::to<std::vector>(), (std::vector<int>{1, 4}));
+  EXPECT_EQ(ranges[1] | coll::to<std::vector>(), (std::vector<int>{7}));
+
+  auto few = coll::range(2).split(3);
+  EXPECT_EQ(few[0] | coll::count(), 1u);
+  EXPECT_EQ(few[1] | coll::count(), 1u);
+  EXPECT_EQ(few[2] | coll::count(), 0u);
+}
@@ -1,5 +1,10 @@
 #if ENABLE_PARALLEL
 
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+
 #include "coll/coll.hpp"
 #include "coll/parallel_coll.hpp"
 #include "gtest/gtest.h"
@@ -66,6 +71,482 @@ GTEST_TEST(Parallel, DoubleSumFewInts) {
   EXPECT_EQ(es * 2, s);
 }
 
+GTEST_TEST(Parallel, DoubleSumBatch) {
+  int n = 4;
+  int es = (0 + 1000 - 1) * 1000 / 2;
+
+  // not a splittable source, so the elements are dispatched in batches
+  int s = *(coll::range(1000)
+    | coll::map(anony_cc(_))
+    | coll::parallel(n, [](size_t, auto in) {
+        return in | coll::map(anony_cc(_ * 2));
+      })
+      .batch(16)
+    | coll::sum());
+
+  EXPECT_EQ(es * 2, s);
+}
+
+GTEST_TEST(Parallel, DoubleSumBatchFewInts) {
+  int n = 4;
+  int es = (0 + 3 - 1) * 3 / 2;
+
+  int s = *(coll::range(3)
+    | coll::parallel(n, [](size_t, auto in) {
+        return in | coll::map(anony_cc(_ * 2));
+      })
+      .shuffle_by(coll::shuffle::RandomAssign{})
+      .batch(16)
+    | coll::sum());
+
+  EXPECT_EQ(es * 2, s);
+}
+
+GTEST_TEST(Parallel, SumBatch) {
+  int n = 4;
+  int es = (0 + 1000 - 1) * 1000 / 2;
+
+  int s = *(coll::range(1000)
+    | coll::parallel(n, [](size_t, auto in) {
+        return in | coll::sum();
+      })
+      .shuffle_by(coll::shuffle::RandomAssign{})
+      .batch(64)
+    | coll::map(anony_ac(_.second.value_or(0)))
+    | coll::sum());
+
+  EXPECT_EQ(s, es);
+}
+
+GTEST_TEST(Parallel, WorkStealingSkewedSum) {
+  int n = 4;
+  int es = (0 + 1000 - 1) * 1000 / 2;
+  std::vector<int> cnts(n, 0);
+
+  int s = *(coll::range(1000)
+    | coll::parallel(n, [&](size_t pid, auto in) {
+        return in
+          | coll::inspect([&, pid](auto&& x) {
+              cnts[pid]++;
+              // a few elements are much more expensive than the others
+              if (x % 100 == 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+              }
+            })
+          | coll::sum();
+      })
+      .shuffle_by(coll::shuffle::WorkStealing(16))
+    | coll::map(anony_ac(_.second.value_or(0)))
+    | coll::sum());
+
+  EXPECT_EQ(s, es);
+  EXPECT_EQ(coll::iterate(cnts) | coll::sum(), 1000);
+}
+
+GTEST_TEST(Parallel, WorkStealingFewInts) {
+  int n = 4;
+  int es = (0 + 3 - 1) * 3 / 2;
+
+  int s = *(coll::range(3)
+    | coll::parallel(n, [](size_t, auto in) {
+        return in | coll::map(anony_cc(_ * 2));
+      })
+      .shuffle_by(coll::shuffle::WorkStealing())
+    | coll::sum());
+
+  EXPECT_EQ(es * 2, s);
+}
+
+GTEST_TEST(Parallel, WorkStealingHeadSum) {
+  int n = 4;
+  std::vector<int> ts(n, -1);
+
+  int s = *(coll::range(1000)
+    | coll::parallel(n, [&](size_t pid, auto in) {
+        return in
+          | coll::inspect([&, pid](auto&& x) {
+              if (ts[pid] == -1) { ts[pid] = x; }
+            })
+          | coll::head();
+      })
+      .shuffle_by(coll::shuffle::WorkStealing(8))
+    | coll::map(anony_ac(_.second.value_or(0)))
+    | coll::sum());
+
+  EXPECT_EQ(*(coll::iterate(ts) | coll::filter(anony_cc(_ != -1)) | coll::sum()), s);
+}
+
+GTEST_TEST(Parallel, OrderedMap) {
+  int n = 4;
+
+  auto res = coll::range(1000)
+    | coll::parallel(n, [](size_t, auto in) {
+        return in
+          | coll::inspect([](auto&& x) {
+              if (x % 97 == 0) {
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+              }
+            })
+          | coll::map(anony_cc(_ * 2));
+      })
+      .ordered(16)
+    | coll::to<std::vector>();
+
+  auto expected = coll::range(1000) | coll::map(anony_cc(_ * 2)) | coll::to<std::vector>();
+  EXPECT_EQ(res, expected);
+}
+
+GTEST_TEST(Parallel, OrderedFilterBatch) {
+  int n = 4;
+
+  auto res = coll::range(1000)
+    | coll::parallel(n, [](size_t, auto in) {
+        return in
+          | coll::filter(anony_cc(_ % 3 == 0))
+          | coll::flatmap(anony_cc(coll::range(_, _ + 2)));
+      })
+      .shuffle_by(coll::shuffle::RandomAssign{})
+      .batch(8)
+      .ordered(32)
+    | coll::to<std::vector>();
+
+  auto expected = coll::range(1000)
+    | coll::filter(anony_cc(_ % 3 == 0))
+    | coll::flatmap(anony_cc(coll::range(_, _ + 2)))
+    | coll::to<std::vector>();
+  EXPECT_EQ(res, expected);
+}
+
+GTEST_TEST(Parallel, OrderedWorkStealing) {
+  int n = 4;
+
+  auto res = coll::range(1000)
+    | coll::parallel(n, [](size_t, auto in) {
+        return in | coll::map(anony_cc(_ + 1));
+      })
+      .shuffle_by(coll::shuffle::WorkStealing(8))
+      .ordered(64)
+    | coll::to<std::vector>();
+
+  auto expected = coll::range(1, 1001) | coll::to<std::vector>();
+  EXPECT_EQ(res, expected);
+}
+
+GTEST_TEST(Parallel, OrderedHead) {
+  int n = 4;
+
+  // each executor takes only its first input
+  auto res = coll::range(100)
+    | coll::parallel(n, [](size_t, auto in) {
+        return in | coll::take_first(1);
+      })
+      .ordered(8)
+    | coll::to<std::vector>();
+
+  EXPECT_LE(res.size(), (size_t) n);
+  for (size_t i = 1; i < res.size(); i++) {
+    EXPECT_LT(res[i - 1], res[i]);
+  }
+}
+
+GTEST_TEST(Parallel, MaxInFlight) {
+  int n = 4;
+  int es = (0 + 1000 - 1) * 1000 / 2;
+  std::atomic<int> num_processed{0};
+  int num_dispatched = 0;
+  int max_lag = 0;
+
+  int s = *(coll::range(1000)
+    | coll::inspect([&](auto&&) {
+        max_lag = std::max(max_lag, num_dispatched++ - num_processed.load());
+      })
+    | coll::parallel(n, [&](size_t, auto in) {
+        return in
+          | coll::inspect([&](auto&&) {
+              std::this_thread::sleep_for(std::chrono::microseconds(20));
+              num_processed++;
+            })
+          | coll::sum();
+      })
+      .shuffle_by(coll::shuffle::RandomAssign{})
+      .max_in_flight(4)
+    | coll::map(anony_ac(_.second.value_or(0)))
+    | coll::sum());
+
+  EXPECT_EQ(s, es);
+  // at most 4 unacknowledged elements per executor
+  EXPECT_LE(max_lag, 4 * n);
+}
+
+GTEST_TEST(Parallel, MaxInFlightBatch) {
+  int n = 4;
+  int es = (0 + 1000 - 1) * 1000 / 2;
+  std::atomic<int> num_processed{0};
+  int num_dispatched = 0;
+  int max_lag = 0;
+
+  int s = *(coll::range(1000)
+    | coll::inspect([&](auto&&) {
+        max_lag = std::max(max_lag, num_dispatched++ - num_processed.load());
+      })
+    | coll::parallel(n, [&](size_t, auto in) {
+        return in
+          | coll::inspect([&](auto&&) { num_processed++; })
+          | coll::map(anony_cc(_ * 2));
+      })
+      .batch(8)
+      .max_in_flight(2)
+    | coll::sum());
+
+  EXPECT_EQ(s, es * 2);
+  // at most 2 unacknowledged batches per executor, plus the batch being packed
+  EXPECT_LE(max_lag, 8 * (2 * n + 1));
+}
+
+GTEST_TEST(Parallel, MaxInFlightWorkStealing) {
+  int n = 4;
+  int es = (0 + 1000 - 1) * 1000 / 2;
+
+  int s = *(coll::range(1000)
+    | coll::parallel(n, [](size_t, auto in) {
+        return in | coll::sum();
+      })
+      .shuffle_by(coll::shuffle::WorkStealing(4))
+      .max_in_flight(1)
+    | coll::map(anony_ac(_.second.value_or(0)))
+    | coll::sum());
+
+  EXPECT_EQ(s, es);
+}
+
+GTEST_TEST(Parallel, MaxInFlightHead) {
+  int n = 4;
+
+  // the executors end early but keep acknowledging, so the operator never blocks forever
+  auto cnt = coll::range(1000)
+    | coll::parallel(n, [](size_t, auto in) {
+        return in | coll::head();
+      })
+      .shuffle_by(coll::shuffle::RandomAssign{})
+      .max_in_flight(1)
+    | coll::count();
+
+  EXPECT_EQ(cnt, (size_t) n);
+}
+
+GTEST_TEST(Parallel, SplitRange) {
+  int n = 4;
+  int es = (0 + 1000 - 1) * 1000 / 2;
+  std::vector<std::vector<int>> ps(n);
+
+  int s = *(coll::range(1000)
+    | coll::parallel(n, [&](size_t pid, auto in) {
+        return in
+          | coll::inspect([&, pid](auto&& x) { ps[pid].push_back(x); })
+          | coll::sum();
+      })
+    | coll::map(anony_ac(_.second.value_or(0)))
+    | coll::sum());
+
+  EXPECT_EQ(s, es);
+  // each executor iterates a consecutive sub-range by itself
+  for (int i = 0; i < n; i++) {
+    EXPECT_EQ(ps[i], coll::range(i * 250, (i + 1) * 250) | coll::to<std::vector>());
+  }
+}
+
+GTEST_TEST(Parallel, SplitIterate) {
+  int n = 3;
+  const std::vector<std::string> words{"a", "bb", "ccc", "dddd", "eeeee", "ffffff", "g"};
+
+  auto lens = coll::iterate(words)
+    | coll::parallel(n, [](size_t, auto in) {
+        return in | coll::map(anony_rc(_.size()));
+      })
+    | coll::sort()
+    | coll::to<std::vector>();
+
+  EXPECT_EQ(lens, (std::vector<size_t>{1, 1, 2, 3, 4, 5, 6}));
+}
+
+GTEST_TEST(Parallel, SplitExecuteBy) {
+  int n = 2;
+  int es = (0 + 1000 - 1) * 1000 / 2;
+  auto& default_pool = coll::parallel_utils::default_executor_pool();
+  coll::ExecutorPool pool(n);
+  zaf::ActorEngine engine{coll::parallel_utils::actor_system, (size_t) n};
+  // the number of elements that see leased workers of the default pool or of `pool`
+  std::atomic<int> num_default_leased{0}, num_leased{0};
+
+  auto args = coll::parallel(n, [&](size_t, auto in) {
+      return in
+        | coll::inspect([&](auto&&) {
+            num_default_leased += default_pool.num_idle_workers() != default_pool.num_workers();
+            num_leased += pool.num_idle_workers() != pool.num_workers();
+          })
+        | coll::sum();
+    });
+  auto sum = [](auto args) {
+    return coll::range(1000)
+      | args
+      | coll::map(anony_ac(_.second.value_or(0)))
+      | coll::sum();
+  };
+
+  // the sub-ranges are iterated on the workers of `pool`
+  EXPECT_EQ(sum(args.execute_by(pool)), es);
+  EXPECT_EQ(num_leased.load(), 1000);
+  EXPECT_EQ(num_default_leased.load(), 0);
+
+  // the range is not split, and the elements are dispatched to the actors of `engine`
+  num_leased = 0;
+  EXPECT_EQ(sum(args.execute_by(engine)), es);
+  EXPECT_EQ(num_leased.load(), 0);
+  EXPECT_EQ(num_default_leased.load(), 0);
+}
+
+GTEST_TEST(Parallel, SplitBreak) {
+  int n = 4;
+
+  // the child breaks early, the executors stop iterating their sub-ranges
+  auto cnt = coll::range(1000000)
+    | coll::parallel(n, [](size_t, auto in) {
+        return in | coll::map(anony_cc(_ + 1));
+      })
+    | coll::take_first(10)
+    | coll::count();
+
+  EXPECT_EQ(cnt, 10u);
+}
+
+GTEST_TEST(Parallel, ChannelDoubleSum) {
+  int n = 4;
+  int es = (0 + 10000 - 1) * 10000 / 2;
+
+  int s = *(coll::range(10000)
+    | coll::parallel(n, [](size_t, auto in) {
+        return in | coll::map(anony_cc(_ * 2));
+      })
+      .with_channels(64)
+    | coll::sum());
+
+  EXPECT_EQ(es * 2, s);
+}
+
+GTEST_TEST(Parallel, ChannelSum) {
+  int n = 4;
+  int es = (0 + 1000 - 1) * 1000 / 2;
+  std::vector<int> ts(n, 0);
+
+  int s = *(coll::range(1000)
+    | coll::parallel(n, [&](size_t pid, auto in) {
+        return in
+          | coll::inspect([&, pid](auto&& x) { ts[pid] += x; })
+          | coll::sum();
+      })
+      .with_channels(16)
+    | coll::map(anony_ac(_.second.value_or(0)))
+    | coll::sum());
+
+  EXPECT_EQ(s, es);
+  EXPECT_EQ(coll::iterate(ts) | coll::sum(), es);
+}
+
+GTEST_TEST(Parallel, ChannelHeadSum) {
+  int n = 4;
+  std::vector<int> ts(n, -1);
+
+  int s = *(coll::range(1000)
+    | coll::parallel(n, [&](size_t pid, auto in) {
+        return in
+          | coll::inspect([&, pid](auto&& x) {
+              if (ts[pid] == -1) { ts[pid] = x; }
+            })
+          | coll::head();
+      })
+      .with_channels(16)
+    | coll::map(anony_ac(_.second.value_or(0)))
+    | coll::sum());
+
+  EXPECT_EQ(*(coll::iterate(ts) | coll::filter(anony_cc(_ != -1)) | coll::sum()), s);
+}
+
+GTEST_TEST(Parallel, ChannelPartition) {
+  int n = 4;
+  int es = (0 + 1000 - 1) * 1000 / 2;
+
+  auto sums = coll::range(1000)
+    | coll::parallel(n, [](size_t, auto in) {
+        return in
+          | coll::partition([](int, auto in) {
+              return in | coll::sum();
+            })
+            .by(anony_cc(_ % 8));
+      })
+      .shuffle_by(coll::shuffle::Partition(anony_cc(_ % 8)))
+      .with_channels(8)
+    | coll::map(anony_ac(std::make_pair(_.first, *_.second)))
+    | coll::to<std::vector>();
+
+  EXPECT_EQ((int) sums.size(), 8);
+  EXPECT_EQ(coll::iterate(sums) | coll::map(anony_ac(_.second)) | coll::sum(), es);
+}
+
+GTEST_TEST(Parallel, ChannelExecutorPoolReuse) {
+  int n = 4;
+  int es = (0 + 100 - 1) * 100 / 2;
+  coll::ExecutorPool pool(n);
+
+  for (int r = 0; r < 5; r++) {
+    int s = *(coll::range(100)
+      | coll::parallel(n, [](size_t, auto in) {
+          return in | coll::sum();
+        })
+        .with_channels(8)
+        .execute_by(pool)
+      | coll::map(anony_ac(_.second.value_or(0)))
+      | coll::sum());
+    EXPECT_EQ(s, es);
+  }
+  EXPECT_EQ(pool.num_workers(), (size_t) n);
+  EXPECT_EQ(pool.num_idle_workers(), (size_t) n);
+}
+
+GTEST_TEST(Parallel, ChannelExecutorPoolNested) {
+  int n = 2;
+  int es = (0 + 100 - 1) * 100 / 2;
+  coll::ExecutorPool pool(n);
+
+  int s = *(coll::range(100)
+    | coll::parallel(n, [](size_t, auto in) {
+        return in | coll::map(anony_cc(_ * 2));
+      })
+      .with_channels(8)
+      .execute_by(pool)
+    | coll::parallel(n, [](size_t, auto in) {
+        return in | coll::sum();
+      })
+      .with_channels(8)
+      .execute_by(pool)
+    | coll::map(anony_ac(_.second.value_or(0)))
+    | coll::sum());
+
+  EXPECT_EQ(s, es * 2);
+  // both stages run at the same time, so the pool grows to serve them
+  EXPECT_EQ(pool.num_workers(), (size_t) n * 2);
+  EXPECT_EQ(pool.num_idle_workers(), (size_t) n * 2);
+}
+
+GTEST_TEST(Parallel, DefaultExecutorPool) {
+  coll::ExecutorPool pool(1);
+  zaf::ActorEngine engine{coll::parallel_utils::actor_system, 1};
+  auto args = coll::parallel(2, [](size_t, auto in) { return in | coll::sum(); });
+  // the actors are spawned on the engine of the default pool, which is kept across executions
+  EXPECT_EQ(&args.get_actor_group(), &coll::parallel_utils::default_executor_pool().actor_group());
+  EXPECT_EQ(&args.execute_by(pool).get_actor_group(), &pool.actor_group());
+  EXPECT_EQ(&args.execute_by(engine).get_actor_group(), &engine);
+}
+
 GTEST_TEST(Parallel, NoResult) {
   int n = 4;
   std::vector<std::vector<int>> ps(n);
@@ -116,4 +597,83 @@ GTEST_TEST(Parallel, ParallelPartitionAlias) {
   EXPECT_EQ(es, s);
 }
 
+GTEST_TEST(Parallel, ParallelPartitionBatch) {
+  int n = 4;
+  int es = (0 + 1000 - 1) * 1000 / 2;
+
+  int s = *(coll::range(1000)
+    | coll::parallel_partition(n, [](int, auto in) {
+        return in | coll::sum();
+      })
+      .key_by(anony_cc(_ % 8))
+      .batch(32)
+    | coll::map(anony_ac(*_.second))
+    | coll::sum());
+
+  EXPECT_EQ(es, s);
+}
+
+GTEST_TEST(Parallel, ParallelPartitionCombine) {
+  int n = 4;
+  int es = (0 + 1000 - 1) * 1000 / 2;
+
+  for (size_t capacity : {1, 3, 1024}) {
+    auto sums = coll::range(1000)
+      | coll::parallel_partition(n, [](int, auto in) {
+          return in | coll::sum();
+        })
+        .key_by(anony_cc(_ % 8))
+        .combine([](int& s, int e) { s += e; }, capacity)
+      | coll::map(anony_ac(std::make_pair(_.first, *_.second)))
+      | coll::sort()
+      | coll::to_vector();
+
+    EXPECT_EQ(sums.size(), 8);
+    int s = 0;
+    for (auto& [k, v] : sums) {
+      EXPECT_EQ(v, (k + 992 + k) * 125 / 2);
+      s += v;
+    }
+    EXPECT_EQ(es, s);
+  }
+}
+
+GTEST_TEST(Parallel, ParallelPartitionCombineCount) {
+  int n = 4;
+
+  auto counts = coll::range(1000)
+    | coll::map(anony_cc(std::make_pair(_ % 10, 1)))
+    | coll::parallel_partition(n, [](int, auto in) {
+        return in | coll::map(anony_rc(_.second)) | coll::sum();
+      })
+      .key_by(anony_ar(_.first))
+      .combine([](auto& p, auto&& e) { p.second += e.second; }, 4)
+    | coll::map(anony_ac(std::make_pair(_.first, *_.second)))
+    | coll::sort()
+    | coll::to_vector();
+
+  EXPECT_EQ(counts.size(), 10);
+  for (int i = 0; i < 10; i++) {
+    EXPECT_EQ(counts[i], std::make_pair(i, 100));
+  }
+}
+
+GTEST_TEST(Parallel, ParallelPartitionExecutorPool) {
+  int n = 4;
+  int es = (0 + 100 - 1) * 100 / 2;
+  coll::ExecutorPool pool(n);
+
+  for (int r = 0; r < 3; r++) {
+    int s = *(coll::range(100)
+      | coll::parallel_partition(n, [](int, auto in) {
+          return in | coll::sum();
+        })
+        .key_by(anony_cc(_ % 8))
+        .execute_by(pool)
+      | coll::map(anony_ac(*_.second))
+      | coll::sum());
+    EXPECT_EQ(es, s);
+  }
+}
+
 #endif
@@ -73,3 +73,122 @@ GTEST_TEST(Partition, Sort) {
     }
   }
 }
+
+GTEST_TEST(Partition, MemoryLimit) {
+  auto expected = coll::range(10000)
+    | coll::partition([](auto&&, auto in) {
+        return in | coll::sum();
+      })
+      .by(anony_cc(_ % 1000))
+    | coll::sort()
+    | coll::to<std::vector>();
+
+  // at most 1 partition in memory
+  auto sums = coll::range(10000)
+    | coll::partition([](auto&&, auto in) {
+        return in | coll::sum();
+      })
+      .by(anony_cc(_ % 1000))
+      .memory_limit(1)
+    | coll::sort()
+    | coll::to<std::vector>();
+  EXPECT_EQ(sums.size(), 1000u);
+  EXPECT_EQ(sums, expected);
+}
+
+GTEST_TEST(Partition, MemoryLimitSizeOf) {
+  auto dir = std::filesystem::temp_directory_path() / "coll-external-partition-size-test";
+  std::filesystem::create_directories(dir);
+
+  // whether some partitions were spilled when the partitions in memory end
+  bool spilled = false;
+  size_t num_partitions = 0;
+  coll::range(10000)
+    | coll::partition([](auto&&, auto in) {
+        return in | coll::to<std::vector>();
+      })
+      .by(anony_cc(std::to_string(_ / 1000)))
+      // at most 4 partitions in memory
+      .memory_limit(4096, [](auto&, auto&) { return size_t(1024); })
+      .spill_dir(dir.string())
+    | coll::foreach([&](auto&& p) {
+        if (num_partitions++ == 0) {
+          spilled = !std::filesystem::is_empty(dir);
+        }
+        EXPECT_EQ(p.second.size(), 1000u);
+      });
+  EXPECT_EQ(num_partitions, 10u);
+  EXPECT_TRUE(spilled);
+  EXPECT_TRUE(std::filesystem::is_empty(dir));
+
+  std::filesystem::remove(dir);
+}
+
+GTEST_TEST(Partition, MaxPartitions) {
+  std::vector<int> keys{1, 2, 1, 3, 1};
+  auto sums = coll::iterate(keys)
+    | coll::partition([](auto&&, auto in) {
+        return in | coll::sum();
+      })
+      .max_partitions(2)
+    | coll::map(anony_ac(std::make_pair(_.first, *_.second)))
+    | coll::to<std::vector>();
+  // 2 is evicted as the least recently used partition when 3 comes
+  ASSERT_EQ(sums.size(), 3u);
+  EXPECT_EQ(sums[0], std::make_pair(2, 2));
+  std::sort(sums.begin() + 1, sums.end());
+  EXPECT_EQ(sums[1], std::make_pair(1, 3));
+  EXPECT_EQ(sums[2], std::make_pair(3, 3));
+
+  // sessions of consecutive keys
+  std::vector<int> clicks{1, 1, 2, 2, 2, 1};
+  auto sessions = coll::iterate(clicks)
+    | coll::partition([](auto&&, auto in) {
+        return in | coll::count();
+      })
+      .max_partitions(1)
+    | coll::to<std::vector>();
+  EXPECT_EQ(sessions, (std::vector<std::pair<int, size_t>>{{1, 2}, {2, 3}, {1, 1}}));
+}
+
+GTEST_TEST(Partition, MaxPartitionsMemoryLimit) {
+  auto dir = std::filesystem::temp_directory_path() / "coll-external-partition-max-test";
+  std::filesystem::create_directories(dir);
+
+  std::vector<int> keys{1, 2, 1, 3, 3, 2, 2};
+  auto counts = coll::iterate(keys)
+    | coll::partition([](auto&&, auto in) {
+        return in | coll::count();
+      })
+      .max_partitions(2)
+      // a partition is estimated to be smaller after its second element,
+      // so the partitions in memory fit into the budget again when 2 comes back
+      .memory_limit(2500, [](auto&, auto& pipe) { return size_t(pipe.result() < 2 ? 3000 : 1000); })
+      .spill_dir(dir.string())
+    | coll::to<std::vector>();
+  // 2 is spilled when it first comes, and its following elements are spilled as well
+  std::sort(counts.begin(), counts.end());
+  EXPECT_EQ(counts, (std::vector<std::pair<int, size_t>>{{1, 2}, {2, 3}, {3, 2}}));
+  EXPECT_TRUE(std::filesystem::is_empty(dir));
+
+  std::filesystem::remove(dir);
+}
+
+GTEST_TEST(Partition, NoEvictionWithoutMaxPartitions) {
+  // every partition is kept and ended exactly once
+  size_t num_constructed = 0;
+  auto sums = coll::range(100)
+    | coll::partition([&](auto&&, auto in) {
+        ++num_constructed;
+        return in | coll::sum();
+      })
+      .by(anony_cc(_ % 10))
+    | coll::map(anony_ac(std::make_pair(_.first, *_.second)))
+    | coll::to<std::vector>();
+  EXPECT_EQ(num_constructed, 10u);
+  std::sort(sums.begin(), sums.end());
+  ASSERT_EQ(sums.size(), 10u);
+  for (int i = 0; i < 10; i++) {
+    EXPECT_EQ(sums[i], std::make_pair(i, 450 + i * 10));
+  }
+}
@@ -1,5 +1,6 @@
 #include <algorithm>
 #include <numeric>
+#include <random>
 #include <vector>
 
 #include "gtest/gtest.h"
@@ -159,3 +160,58 @@ TEST_F(Sink, LastGoat) {
   EXPECT_EQ(ScapegoatCounter::num_scapegoat_copy, 0);
   EXPECT_EQ(ScapegoatCounter::num_scapegoat_move, 0);
 }
+
+TEST_F(Sink, ApproxCountDistinct) {
+  auto exact = coll::iterate(Sink::ints) | coll::distinct() | coll::count();
+  auto approx = coll::iterate(Sink::ints) | coll::approx_count_distinct();
+  EXPECT_NEAR(approx, exact, exact * 0.05);
+
+  auto many = coll::range(1000000) | coll::approx_count_distinct(14);
+  EXPECT_NEAR(many, 1000000, 1000000 * 0.03);
+
+  // the sketches of disjoint halves merge into the one of the whole
+  auto a = coll::range(0, 500000) | coll::approx_count_distinct(14).sketch();
+  auto b = coll::range(500000, 1000000) | coll::approx_count_distinct(14).sketch();
+  auto whole = coll::range(1000000) | coll::approx_count_distinct(14).sketch();
+  a.merge(b);
+  EXPECT_EQ(a, whole);
+  EXPECT_THROW(a.merge(coll::HyperLogLog(10)), std::invalid_argument);
+
+  auto groups = coll::iterate(Sink::ints)
+    | coll::groupby(anony_rc(_ % 2))
+        .approx_count_distinct();
+  auto exact_groups = coll::iterate(Sink::ints)
+    | coll::groupby(anony_rc(_ % 2))
+        .aggregate(coll::FlatHashSet<int>(), [](auto& set, auto v) { set.insert(v); });
+  for (auto& [k, hll] : groups) {
+    EXPECT_NEAR(hll.estimate(), exact_groups.at(k).size(), exact_groups.at(k).size() * 0.05);
+  }
+}
+
+TEST_F(Sink, Quantiles) {
+  EXPECT_TRUE((coll::iterate(std::vector<int>{}) | coll::quantiles({0.5})).empty());
+  EXPECT_EQ(coll::iterate(Sink::ints) | coll::quantiles({0, 1}),
+            (std::vector<int>{
+              *std::min_element(Sink::ints.begin(), Sink::ints.end()),
+              *std::max_element(Sink::ints.begin(), Sink::ints.end())}));
+
+  // a random permutation of [1, n], whose q-quantile is q * n
+  int n = 1000000;
+  std::vector<int> perm(n);
+  std::iota(perm.begin(), perm.end(), 1);
+  std::shuffle(perm.begin(), perm.end(), std::mt19937(0));
+  auto qs = coll::iterate(perm) | coll::quantiles({0.5, 0.99, 0.999});
+  ASSERT_EQ(qs.size(), 3u);
+  EXPECT_NEAR(qs[0], n * 0.5, n * 0.01);
+  EXPECT_NEAR(qs[1], n * 0.99, n * 0.01);
+  EXPECT_NEAR(qs[2], n * 0.999, n * 0.01);
+
+  // the sketches of two halves merge into one of the whole
+  auto a = coll::iterate(perm.data(), perm.data() + n / 2) | coll::quantiles({}).sketch();
+  auto b = coll::iterate(perm.data() + n / 2, perm.data() + n) | coll::quantiles({}).sketch();
+  a.merge(b);
+  EXPECT_EQ(a.size(), size_t(n));
+  EXPECT_LT(a.num_retained_items(), 1000u);
+  EXPECT_NEAR(a.quantile(0.5), n * 0.5, n * 0.01);
+  EXPECT_NEAR(a.quantile(0.99), n * 0.99, n * 0.01);
+}
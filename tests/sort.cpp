@@ -1,3 +1,5 @@
+#include <filesystem>
+
 #include "gtest/gtest.h"
 
 #include "coll/coll.hpp"
@@ -110,3 +112,270 @@ TEST_F(Sort, ReverseSortByRefThenReverse) {
   EXPECT_EQ(ScapegoatCounter::num_scapegoat_copy, 0);
   EXPECT_EQ(ScapegoatCounter::num_scapegoat_move, 0);
 }
+
+GTEST_TEST(ParallelSort, Basic) {
+  auto ints = coll::range(100000)
+    | coll::map(anony_cc(rand() % 1000))
+    | coll::to<std::vector>();
+  auto expected = ints;
+  std::sort(expected.begin(), expected.end());
+
+  auto sorted = coll::iterate(ints)
+    | coll::sort().parallel(4)
+    | coll::to<std::vector>();
+  EXPECT_EQ(sorted, expected);
+}
+
+GTEST_TEST(ParallelSort, ComparatorAndReverse) {
+  auto ints = coll::range(100000)
+    | coll::map(anony_cc(rand()))
+    | coll::to<std::vector>();
+  auto expected = ints;
+  std::sort(expected.begin(), expected.end(), std::greater<int>());
+
+  auto sorted = coll::iterate(ints)
+    | coll::sort([](auto& a, auto& b) { return b < a; }).parallel(3)
+    | coll::to<std::vector>();
+  EXPECT_EQ(sorted, expected);
+
+  auto reversed = coll::iterate(ints)
+    | coll::sort().parallel(3)
+    | coll::reverse()
+    | coll::to<std::vector>();
+  EXPECT_EQ(reversed, expected);
+}
+
+GTEST_TEST(ParallelSort, CacheByRef) {
+  std::vector<Scapegoat> vals;
+  coll::range(50000)
+    | coll::map(anony_cc(Scapegoat{rand() % 5000}))
+    | coll::to(vals);
+  auto expected = coll::iterate(vals)
+    | coll::map(anony_rc(_.val))
+    | coll::sort()
+    | coll::to<std::vector>();
+
+  ScapegoatCounter::clear();
+  auto sorted = coll::iterate(vals)
+    | coll::sort(anony_rc(_.val)).cache_by_ref().parallel(4)
+    | coll::map(anony_rr(_.val))
+    | coll::to<std::vector>();
+  EXPECT_EQ(sorted, expected);
+  EXPECT_EQ(ScapegoatCounter::num_scapegoat_copy, 0);
+  EXPECT_EQ(ScapegoatCounter::num_scapegoat_move, 0);
+}
+
+GTEST_TEST(ParallelSort, ExecuteBy) {
+  auto ints = coll::range(100000)
+    | coll::map(anony_cc(rand() % 1000))
+    | coll::to<std::vector>();
+  auto expected = ints;
+  std::sort(expected.begin(), expected.end());
+
+  // 3 workers are leased besides the calling thread, and are given back for the next execution
+  coll::ExecutorPool pool(0);
+  for (int i = 0; i < 3; i++) {
+    auto sorted = coll::iterate(ints)
+      | coll::sort().parallel(4).execute_by(pool)
+      | coll::to<std::vector>();
+    EXPECT_EQ(sorted, expected);
+    EXPECT_EQ(pool.num_workers(), 3u);
+    EXPECT_EQ(pool.num_idle_workers(), 3u);
+  }
+}
+
+GTEST_TEST(ParallelSort, FewElements) {
+  // too few elements to sort in parallel
+  auto sorted = coll::elements(3, 1, 2)
+    | coll::sort().parallel(8)
+    | coll::to<std::vector>();
+  EXPECT_EQ(sorted, (std::vector<int>{1, 2, 3}));
+}
+
+GTEST_TEST(RadixSort, Integers) {
+  auto ints = coll::range(100000)
+    | coll::map(anony_cc(rand() - RAND_MAX / 2))
+    | coll::to<std::vector>();
+  auto expected = ints;
+  std::sort(expected.begin(), expected.end());
+
+  auto sorted = coll::iterate(ints)
+    | coll::sort()
+    | coll::to<std::vector>();
+  EXPECT_EQ(sorted, expected);
+
+  auto radix_sorted = coll::elements(3, -1, 2, 0, -5)
+    | coll::sort().radix()
+    | coll::to<std::vector>();
+  EXPECT_EQ(radix_sorted, (std::vector<int>{-5, -1, 0, 2, 3}));
+
+  auto unsigned_sorted = coll::iterate(ints)
+    | coll::map(anony_rc(uint64_t(_) * 1000003))
+    | coll::sort().radix()
+    | coll::to<std::vector>();
+  EXPECT_TRUE(std::is_sorted(unsigned_sorted.begin(), unsigned_sorted.end()));
+}
+
+GTEST_TEST(RadixSort, Reverse) {
+  auto ints = coll::range(5000)
+    | coll::map(anony_cc(short(rand())))
+    | coll::to<std::vector>();
+  auto expected = ints;
+  std::sort(expected.begin(), expected.end(), std::greater<short>());
+
+  auto sorted = coll::iterate(ints)
+    | coll::sort().radix().reverse()
+    | coll::to<std::vector>();
+  EXPECT_EQ(sorted, expected);
+
+  auto reversed = coll::iterate(ints)
+    | coll::sort().radix()
+    | coll::reverse()
+    | coll::to<std::vector>();
+  EXPECT_EQ(reversed, expected);
+}
+
+GTEST_TEST(RadixSort, Mapper) {
+  std::vector<Scapegoat> vals;
+  coll::range(3000)
+    | coll::map(anony_cc(Scapegoat{rand() % 100 - 50}))
+    | coll::to(vals);
+  // radix sort is stable
+  auto expected = vals;
+  std::stable_sort(expected.begin(), expected.end(),
+    [](auto& a, auto& b) { return a.val < b.val; });
+
+  auto sorted = coll::iterate(vals)
+    | coll::sort(anony_rc(_.val)).radix()
+    | coll::map(anony_rr(_.val))
+    | coll::to<std::vector>();
+  EXPECT_EQ(sorted, (coll::iterate(expected) | coll::map(anony_rc(_.val)) | coll::to<std::vector>()));
+
+  ScapegoatCounter::clear();
+  auto sorted_by_ref = coll::iterate(vals)
+    | coll::sort(anony_rc(_.val)).radix().cache_by_ref().reverse()
+    | coll::reverse()
+    | coll::map(anony_rr(_.val))
+    | coll::to<std::vector>();
+  EXPECT_EQ(sorted_by_ref, sorted);
+  EXPECT_EQ(ScapegoatCounter::num_scapegoat_copy, 0);
+  EXPECT_EQ(ScapegoatCounter::num_scapegoat_move, 0);
+}
+
+GTEST_TEST(ExternalSort, Basic) {
+  auto dir = std::filesystem::temp_directory_path() / "coll-external-sort-test";
+  std::filesystem::create_directories(dir);
+
+  auto ints = coll::range(100000)
+    | coll::map(anony_cc(rand()))
+    | coll::to<std::vector>();
+  auto expected = ints;
+  std::sort(expected.begin(), expected.end());
+
+  size_t num_spill_files = 0;
+  auto sorted = coll::iterate(ints)
+    | coll::sort().memory_limit(8192 * sizeof(int)).spill_dir(dir.string())
+    | coll::inspect([&](auto&&) {
+        if (num_spill_files == 0) {
+          num_spill_files = std::distance(std::filesystem::directory_iterator(dir), {});
+        }
+      })
+    | coll::to<std::vector>();
+  EXPECT_EQ(sorted, expected);
+  EXPECT_EQ(num_spill_files, 100000 / 8192);
+  // spill files are removed once sorted
+  EXPECT_TRUE(std::filesystem::is_empty(dir));
+
+  auto reversed = coll::iterate(ints)
+    | coll::sort().reverse().memory_limit(8192 * sizeof(int)).spill_dir(dir.string())
+    | coll::reverse()
+    | coll::to<std::vector>();
+  EXPECT_EQ(reversed, expected);
+
+  auto head = coll::iterate(ints)
+    | coll::sort().memory_limit(1000 * sizeof(int)).spill_dir(dir.string())
+    | coll::head();
+  EXPECT_EQ(head, expected.front());
+  EXPECT_TRUE(std::filesystem::is_empty(dir));
+
+  std::filesystem::remove(dir);
+}
+
+GTEST_TEST(ExternalSort, Serialization) {
+  auto strs = coll::range(10000)
+    | coll::map(anony_cc(std::make_pair(std::to_string(rand() % 1000), rand())))
+    | coll::to<std::vector>();
+  auto expected = strs;
+  std::sort(expected.begin(), expected.end());
+
+  auto sorted = coll::iterate(strs)
+    | coll::sort().memory_limit(1000 * sizeof(strs[0]))
+    | coll::to<std::vector>();
+  EXPECT_EQ(sorted, expected);
+
+  auto sorted_by_mapper = coll::iterate(strs)
+    | coll::sort(anony_rr(_.second)).memory_limit(1000 * sizeof(strs[0]))
+    | coll::map(anony_rc(_.second))
+    | coll::to<std::vector>();
+  EXPECT_TRUE(std::is_sorted(sorted_by_mapper.begin(), sorted_by_mapper.end()));
+  EXPECT_EQ(sorted_by_mapper.size(), strs.size());
+}
+
+GTEST_TEST(SortLimit, Basic) {
+  auto ints = coll::range(100000)
+    | coll::map(anony_cc(rand()))
+    | coll::to<std::vector>();
+  auto expected = ints;
+  std::sort(expected.begin(), expected.end());
+  expected.resize(100);
+
+  auto top = coll::iterate(ints)
+    | coll::sort().limit(100)
+    | coll::to<std::vector>();
+  EXPECT_EQ(top, expected);
+
+  auto taken = coll::iterate(ints)
+    | coll::sort()
+    | coll::take_first(100)
+    | coll::to<std::vector>();
+  EXPECT_EQ(taken, expected);
+
+  auto first = coll::iterate(ints)
+    | coll::sort()
+    | coll::head();
+  EXPECT_EQ(first, expected.front());
+
+  auto empty = coll::iterate(ints)
+    | coll::sort().limit(0)
+    | coll::to<std::vector>();
+  EXPECT_TRUE(empty.empty());
+}
+
+GTEST_TEST(SortLimit, ReverseAndRef) {
+  std::vector<Scapegoat> vals;
+  coll::range(5000)
+    | coll::map(anony_cc(Scapegoat{rand() % 10000}))
+    | coll::to(vals);
+  auto expected = coll::iterate(vals)
+    | coll::map(anony_rc(_.val))
+    | coll::sort().reverse()
+    | coll::to<std::vector>();
+  expected.resize(10);
+
+  ScapegoatCounter::clear();
+  auto top = coll::iterate(vals)
+    | coll::sort(anony_rc(_.val)).reverse().cache_by_ref()
+    | coll::take_first(10)
+    | coll::map(anony_rr(_.val))
+    | coll::to<std::vector>();
+  EXPECT_EQ(top, expected);
+  EXPECT_EQ(ScapegoatCounter::num_scapegoat_copy, 0);
+  EXPECT_EQ(ScapegoatCounter::num_scapegoat_move, 0);
+
+  auto bottom = coll::iterate(vals)
+    | coll::sort(anony_rc(_.val)).cache_by_ref().limit(10)
+    | coll::reverse()
+    | coll::map(anony_rr(_.val))
+    | coll::to<std::vector>();
+  EXPECT_EQ(bottom, expected);
+}
@@ -0,0 +1,109 @@
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "coll/coll.hpp"
+
+class SplitText : public ::testing::Test {
+public:
+  // random text of words, delimiters and non-ascii bytes, with some long words
+  inline static std::string text;
+
+protected:
+  static void SetUpTestSuite() {
+    const char chars[] = "ab_Z09 \t\n,.\x80\xff";
+    for (int i = 0; i < 100000; i++) {
+      if (rand() % 1000 == 0) {
+        text.append(rand() % 500, 'x');
+      }
+      text.push_back(chars[rand() % (sizeof(chars) - 1)]);
+    }
+  }
+
+  template<typename Pred>
+  static std::vector<std::string> expected_tokens(std::string_view text, Pred is_delimiter) {
+    std::vector<std::string> tokens;
+    coll::iterate(text)
+      | coll::split(std::string(), is_delimiter)
+      | coll::to(tokens);
+    return tokens;
+  }
+
+  static void TearDownTestSuite() {}
+};
+
+TEST_F(SplitText, Text) {
+  auto tokens = coll::split_text(SplitText::text, " \t\n")
+    | coll::map(anony_cc(std::string(_)))
+    | coll::to<std::vector>();
+  EXPECT_EQ(tokens, expected_tokens(SplitText::text, anony_cc(_ == ' ' || _ == '\t' || _ == '\n')));
+
+  // delimiters with the high nibbles 0-7 and 8-15
+  auto is_delimiter = [](char c) {
+    return !std::isalnum((unsigned char) c) && c != '_';
+  };
+  tokens = coll::split_text(SplitText::text, is_delimiter)
+    | coll::map(anony_cc(std::string(_)))
+    | coll::to<std::vector>();
+  EXPECT_EQ(tokens, expected_tokens(SplitText::text, is_delimiter));
+
+  EXPECT_EQ(coll::split_text("", " ") | coll::count(), 0u);
+  EXPECT_EQ(coll::split_text("   ", " ") | coll::count(), 0u);
+  EXPECT_EQ(coll::split_text(" a  bc ", " ") | coll::map(anony_cc(std::string(_))) | coll::to<std::vector>(),
+            (std::vector<std::string>{"a", "bc"}));
+}
+
+TEST_F(SplitText, Classify) {
+  // the sets of delimiters that are compared, or classified by the nibble tables or the 256-entry table
+  std::vector<coll::DelimiterSet> sets{
+    coll::DelimiterSet(" "),
+    coll::DelimiterSet(" \t\n,.;:!"),
+    coll::DelimiterSet(" \t\n,.;:!?"),
+    coll::DelimiterSet([](char c) { return !std::isalnum((unsigned char) c) && c != '_'; }),
+    coll::DelimiterSet([](char c) { return (unsigned char) c % 3 == 0; })
+  };
+  char bytes[64];
+  for (int n = 0; n < 100; n++) {
+    for (auto& b : bytes) {
+      b = char(rand() % 256);
+    }
+    for (auto& delimiters : sets) {
+      uint64_t expected = 0;
+      for (size_t i = 0; i < 64; i++) {
+        expected |= uint64_t(delimiters.contains(bytes[i])) << i;
+      }
+      EXPECT_EQ(delimiters.classify(bytes), expected);
+    }
+  }
+}
+
+TEST_F(SplitText, Stream) {
+  auto expected = expected_tokens(SplitText::text, anony_cc(_ == ' ' || _ == ',' || _ == '.'));
+  // the blocks are smaller than the long words
+  for (size_t block_size : {64, 100, 4096, 1 << 20}) {
+    std::istringstream in(SplitText::text);
+    auto tokens = coll::split_text(in, " ,.", block_size)
+      | coll::map(anony_cc(std::string(_)))
+      | coll::to<std::vector>();
+    EXPECT_EQ(tokens, expected);
+  }
+
+  std::istringstream in(SplitText::text);
+  auto first = coll::split_text(in, " ,.")
+    | coll::map(anony_cc(std::string(_)))
+    | coll::head();
+  ASSERT_TRUE(first.has_value());
+  EXPECT_EQ(*first, expected.front());
+}
+
+TEST_F(SplitText, Operator) {
+  std::vector<std::string> lines{"hello world", "", "  split  text  ", "x"};
+  auto tokens = coll::iterate(lines)
+    | coll::split_text(" ")
+    | coll::map(anony_cc(std::string(_)))
+    | coll::to<std::vector>();
+  EXPECT_EQ(tokens, (std::vector<std::string>{"hello", "world", "split", "text", "x"}));
+}
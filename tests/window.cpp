@@ -153,3 +153,209 @@ TEST_F(Window, 5_6_REF_REV) {
   EXPECT_EQ(ScapegoatCounter::num_scapegoat_copy, 0);
   EXPECT_EQ(ScapegoatCounter::num_scapegoat_move, 0);
 }
+
+TEST_F(Window, Aggregate) {
+  std::vector<int> ints;
+  coll::range(1000)
+    | coll::map(anony_cc(rand() % 1000 - 500))
+    | coll::to(ints);
+
+  for (auto [size, step] : {std::pair<size_t, size_t>{1, 1}, {7, 1}, {7, 3}, {5, 6}, {2000, 1}}) {
+    // evaluate each window by re-scanning it
+    auto expect = [&](auto agg) {
+      return coll::iterate(ints)
+        | coll::window(size, step)
+        | coll::map([&](auto& w) { return agg(w); })
+        | coll::to<std::vector>();
+    };
+    auto aggregate = [&](auto op) {
+      return coll::iterate(ints)
+        | coll::window(size, step).aggregate(op)
+        | coll::to<std::vector>();
+    };
+
+    EXPECT_EQ(aggregate(coll::window_ops::count()),
+              expect(anony_rc(_.size())));
+    EXPECT_EQ(aggregate(coll::window_ops::sum()),
+              expect(anony_rc(*(coll::iterate(_) | coll::sum()))));
+    EXPECT_EQ(aggregate(coll::window_ops::avg()),
+              expect(anony_rc(*(coll::iterate(_) | coll::sum()) / int(_.size()))));
+    EXPECT_EQ(aggregate(coll::window_ops::max()),
+              expect(anony_rc(*(coll::iterate(_) | coll::max()))));
+    EXPECT_EQ(aggregate(coll::window_ops::min()),
+              expect(anony_rc(*(coll::iterate(_) | coll::min()))));
+    EXPECT_EQ(aggregate([](auto& a, auto b) { a = std::max(a, b); }),
+              expect(anony_rc(*(coll::iterate(_) | coll::max()))));
+  }
+}
+
+TEST_F(Window, AggregateReduce) {
+  // concatenation is associative but not commutative
+  auto concats = coll::range(10)
+    | coll::map(anony_cc(std::to_string(_)))
+    | coll::window(4, 1).aggregate([](auto& a, auto&& b) { a += b; })
+    | coll::to<std::vector>();
+  EXPECT_EQ(concats, (std::vector<std::string>{
+    "0123", "1234", "2345", "3456", "4567", "5678", "6789"
+  }));
+
+  auto tails = coll::range(10)
+    | coll::map(anony_cc(std::to_string(_)))
+    | coll::window(4, 3).aggregate([](auto& a, auto&& b) { a += b; })
+    | coll::to<std::vector>();
+  EXPECT_EQ(tails, (std::vector<std::string>{"0123", "3456", "6789"}));
+}
+
+TEST_F(Window, ByTime) {
+  // (time, value) arriving at most 3 later than the max time seen
+  std::vector<std::pair<int, int>> events{
+    {0, 0}, {2, 1}, {1, 2}, {5, 3}, {3, 4}, {9, 5}, {7, 6}, {12, 7}, {25, 8}, {2, 9}, {24, 10}
+  };
+  auto windows = [&](auto args) {
+    std::vector<std::tuple<int, int, std::vector<int>>> res;
+    coll::iterate(events)
+      | coll::map(anony_rc(_))
+      | args
+      | coll::foreach([&](auto& w) {
+          res.emplace_back(w.begin_time, w.end_time,
+            coll::iterate(w) | coll::map(anony_rc(_.second)) | coll::to<std::vector>());
+        });
+    return res;
+  };
+
+  using Windows = std::vector<std::tuple<int, int, std::vector<int>>>;
+  // {2, 9} is dropped as [0, 5) has been output
+  EXPECT_EQ(windows(coll::window_by_time(anony_rc(_.first), 5).allowed_lateness(3)), (Windows{
+    {0, 5, {0, 2, 1, 4}}, {5, 10, {3, 6, 5}}, {10, 15, {7}}, {20, 25, {10}}, {25, 30, {8}}
+  }));
+  // {2, 9} is in [0, 10), which is output after 12 arrives
+  EXPECT_EQ(windows(coll::window_by_time(anony_rc(_.first), 10, 5).allowed_lateness(3)), (Windows{
+    {-5, 5, {0, 2, 1, 4}}, {0, 10, {0, 2, 1, 4, 3, 6, 5}}, {5, 15, {3, 6, 5, 7}},
+    {10, 20, {7}}, {15, 25, {10}}, {20, 30, {10, 8}}, {25, 35, {8}}
+  }));
+  // 1 and 7 are in the gaps between windows
+  EXPECT_EQ(windows(coll::window_by_time(anony_rc(_.first), 1, 3).allowed_lateness(3)), (Windows{
+    {0, 1, {0}}, {3, 4, {4}}, {9, 10, {5}}, {12, 13, {7}}, {24, 25, {10}}
+  }));
+  // 12 starts a new session as it is not within the gap after 9
+  EXPECT_EQ(windows(coll::session_window(anony_rc(_.first), 3).allowed_lateness(3)), (Windows{
+    {0, 12, {0, 2, 1, 4, 3, 6, 5}}, {12, 15, {7}}, {24, 28, {10, 8}}
+  }));
+  // without lateness, 3 and 7 are dropped as they are before the end of the last session
+  EXPECT_EQ(windows(coll::session_window(anony_rc(_.first), 3)), (Windows{
+    {0, 5, {0, 2, 1}}, {5, 8, {3}}, {9, 12, {5}}, {12, 15, {7}}, {24, 28, {10, 8}}
+  }));
+}
+
+TEST_F(Window, ByTimeUnsigned) {
+  auto windows = [](const std::vector<size_t>& times, auto args) {
+    std::vector<std::tuple<size_t, size_t, std::vector<size_t>>> res;
+    coll::iterate(times)
+      | args
+      | coll::foreach([&](auto& w) {
+          res.emplace_back(w.begin_time, w.end_time, coll::iterate(w) | coll::to<std::vector>());
+        });
+    return res;
+  };
+
+  using Windows = std::vector<std::tuple<size_t, size_t, std::vector<size_t>>>;
+  // the windows start from 0 instead of wrapping around
+  EXPECT_EQ(windows({1, 3, 12, 14, 25}, coll::window_by_time(anony_cc(_), size_t(10), size_t(5))), (Windows{
+    {0, 10, {1, 3}}, {5, 15, {12, 14}}, {10, 20, {12, 14}}, {20, 30, {25}}, {25, 35, {25}}
+  }));
+  // the watermark is 0 instead of wrapping around before 5 arrives
+  EXPECT_EQ(windows({3, 1, 12, 14}, coll::window_by_time(anony_cc(_), size_t(5)).allowed_lateness(size_t(5))), (Windows{
+    {0, 5, {1, 3}}, {10, 15, {12, 14}}
+  }));
+  EXPECT_EQ(windows({3, 1, 12, 14}, coll::session_window(anony_cc(_), size_t(3)).allowed_lateness(size_t(5))), (Windows{
+    {1, 6, {1, 3}}, {12, 17, {12, 14}}
+  }));
+}
+
+TEST_F(Window, ByTimeBounded) {
+  // the buffered elements are bounded while the windows are output one by one
+  int num_windows = 0;
+  coll::range(1000000)
+    | coll::window_by_time(anony_cc(_), 1000, 100)
+    | coll::foreach([&](auto& w) {
+        EXPECT_EQ(w.begin_time, (num_windows - 9) * 100);
+        EXPECT_EQ(w.size(), size_t(std::min(w.end_time, 1000000) - std::max(w.begin_time, 0)));
+        ++num_windows;
+      });
+  EXPECT_EQ(num_windows, 1000000 / 100 + 9);
+
+  auto first = coll::range(1000000)
+    | coll::session_window(anony_cc(_ / 1000 * 2000), 1000)
+    | coll::head();
+  ASSERT_TRUE(first.has_value());
+  EXPECT_EQ(first->size(), 1000u);
+}
+
+TEST_F(Window, Contiguous) {
+  auto to_vectors = [](auto window) {
+    return window
+      | coll::map([](auto& w) { return coll::iterate(w) | coll::to<std::vector>(); })
+      | coll::to<std::vector>();
+  };
+  for (int n : {0, 3, 20, 21}) {
+    std::vector<int> ints;
+    coll::range(n) | coll::to(ints);
+    for (auto [size, step] : {std::pair<size_t, size_t>{1, 1}, {5, 1}, {5, 4}, {5, 5}, {5, 6}, {30, 2}}) {
+      EXPECT_EQ(to_vectors(coll::iterate(ints) | coll::window(size, step).as_view()),
+                to_vectors(coll::iterate(ints) | coll::window(size, step)));
+    }
+  }
+
+  // the windows are views of the source only with `as_view()`
+  static_assert(!decltype(coll::iterate(Window::vals) | coll::window(5, 2))::is_contiguous, "");
+  ScapegoatCounter::clear();
+  int num_windows = 0;
+  coll::iterate(Window::vals)
+    | coll::window(5, 2).as_view()
+    | coll::foreach([&](auto& w) {
+        EXPECT_EQ(w.data(), Window::vals.data() + num_windows * 2);
+        ++num_windows;
+      });
+  EXPECT_EQ(num_windows, (20 - 5) / 2 + 1 + 1);
+  EXPECT_EQ(ScapegoatCounter::num_scapegoat_copy, 0);
+  EXPECT_EQ(ScapegoatCounter::num_scapegoat_move, 0);
+}
+
+TEST_F(Window, Fixed) {
+  auto to_vectors = [](auto window) {
+    return window
+      | coll::map([](auto& w) { return coll::iterate(w) | coll::to<std::vector>(); })
+      | coll::to<std::vector>();
+  };
+  std::vector<int> vals;
+  coll::range(21) | coll::map(anony_cc(rand() % 100)) | coll::to(vals);
+  // fixed windows keep the elements in a `std::array` also on a contiguous source
+  static_assert(std::is_same<
+    decltype(coll::iterate(vals) | coll::window<8, 1>())::WindowType,
+    coll::FixedWindowedElements<int&, 8, 1, false>
+  >::value, "");
+  auto ints = coll::iterate(vals);
+  EXPECT_EQ(to_vectors(ints | coll::window<1>()), to_vectors(ints | coll::window(1)));
+  EXPECT_EQ(to_vectors(ints | coll::window<5, 1>()), to_vectors(ints | coll::window(5, 1)));
+  EXPECT_EQ(to_vectors(ints | coll::window<5, 4>()), to_vectors(ints | coll::window(5, 4)));
+  EXPECT_EQ(to_vectors(ints | coll::window<5, 6>()), to_vectors(ints | coll::window(5, 6)));
+  EXPECT_EQ(to_vectors(ints | coll::window<8, 3>()), to_vectors(ints | coll::window(8, 3)));
+  EXPECT_EQ(to_vectors(ints | coll::window<30, 2>()), to_vectors(ints | coll::window(30, 2)));
+
+  ScapegoatCounter::clear();
+  int num_windows = 0;
+  coll::iterate(Window::vals)
+    | coll::map(anony_rr(_))
+    | coll::window<5, 1>().cache_by_ref()
+    | coll::foreach([&, i = 0](auto&& w) mutable {
+        ++num_windows;
+        EXPECT_EQ((int) w.size(), 5);
+        for (int j = 0; j < 5; j++) {
+          EXPECT_EQ(w[j], Window::vals[i + j]);
+        }
+        i++;
+      });
+  EXPECT_EQ(num_windows, 20 - 5 + 1);
+  EXPECT_EQ(ScapegoatCounter::num_scapegoat_copy, 0);
+  EXPECT_EQ(ScapegoatCounter::num_scapegoat_move, 0);
+}